@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "accumulator.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+#define MAX_LONG_LIMBS 3 /* a long magnitude never needs more than three 9-digit limbs */
+
+
+/**
+ * @brief  splits the magnitude of a long into base 10^9 limbs.
+ * @note   LONG_MIN is handled by negating in unsigned arithmetic.
+ * @param  value: value to split (Type: Long).
+ * @param  pulLimbs: receives up to MAX_LONG_LIMBS limbs, least significant first (Type: Unsigned Long array).
+ * @param  piNegative: receives TRUE if value is negative (Type: Pointer to Integer).
+ * @retval returns the amount of limbs used, 0 for zero.
+ */
+static int splitLong( long value, unsigned long* pulLimbs, int* piNegative ) {
+    unsigned long magnitude;
+    int count = 0;
+
+    *piNegative = ( value < 0 );
+    magnitude = ( value < 0 ) ? 0UL - ( unsigned long ) value : ( unsigned long ) value;
+
+    while ( magnitude > 0 ) {
+        pulLimbs[count++] = magnitude % ACCUMULATOR_LIMB_BASE;
+        magnitude /= ACCUMULATOR_LIMB_BASE;
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief  compares two magnitudes stored as limbs without leading zero limbs.
+ * @retval returns -1, 0 or 1 as A is smaller, equal or larger than B.
+ */
+static int compareMagnitude( const unsigned long* pulA, int countA, const unsigned long* pulB, int countB ) {
+    int index;
+
+    if ( countA != countB ) {
+        return ( countA < countB ) ? -1 : 1;
+    }
+
+    for ( index = countA - 1 ; index >= 0 ; index-- ) {
+        if ( pulA[index] != pulB[index] ) {
+            return ( pulA[index] < pulB[index] ) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief  makes sure the accumulator can hold a given amount of limbs.
+ * @note   grows by doubling so repeated carries into a new limb stay amortised constant time.
+ * @retval returns TRUE on success, FALSE if realloc failed.
+ */
+static int reserveLimbs( Accumulator* pAcc, int count ) {
+    unsigned long* pulLimbs;
+    int capacity = ( pAcc->limbCapacity > 0 ) ? pAcc->limbCapacity : 4;
+
+    if ( count <= pAcc->limbCapacity ) {
+        return TRUE;
+    }
+
+    while ( capacity < count ) {
+        capacity *= 2;
+    }
+
+    pulLimbs = ( unsigned long* ) realloc( pAcc->pulLimbs, sizeof( unsigned long ) * ( size_t ) capacity );
+    if ( pulLimbs == NULL ) {
+        return FALSE;
+    }
+
+    pAcc->pulLimbs = pulLimbs;
+    pAcc->limbCapacity = capacity;
+    return TRUE;
+}
+
+
+/**
+ * @brief  moves the value out of the long fast path into limbs.
+ * @retval returns TRUE on success, FALSE if realloc failed, leaving the value on the long fast path.
+ */
+static int promote( Accumulator* pAcc ) {
+    unsigned long aulLimbs[MAX_LONG_LIMBS];
+    int negative;
+    int count = splitLong( pAcc->small, aulLimbs, &negative );
+
+    if ( !reserveLimbs( pAcc, MAX_LONG_LIMBS + 1 ) ) {
+        return FALSE;
+    }
+    memcpy( pAcc->pulLimbs, aulLimbs, sizeof( unsigned long ) * ( size_t ) count );
+    pAcc->limbCount = count;
+    pAcc->negative = negative;
+    pAcc->isBig = TRUE;
+    return TRUE;
+}
+
+
+/**
+ * @brief  trims leading zero limbs and moves the value back to the long fast path when it fits again.
+ * @note   two limbs hold at most 10^18 - 1, which always fits in a 64-bit long.
+ * @retval None
+ */
+static void normalise( Accumulator* pAcc ) {
+    while ( pAcc->limbCount > 0 && pAcc->pulLimbs[pAcc->limbCount - 1] == 0 ) {
+        pAcc->limbCount--;
+    }
+
+    if ( pAcc->limbCount <= 2 && sizeof( long ) >= 8 ) {
+        pAcc->small = ( long ) ( ( pAcc->limbCount > 1 ? pAcc->pulLimbs[1] * ACCUMULATOR_LIMB_BASE : 0 ) + ( pAcc->limbCount > 0 ? pAcc->pulLimbs[0] : 0 ) );
+        if ( pAcc->negative ) {
+            pAcc->small = -pAcc->small;
+        }
+        pAcc->isBig = FALSE;
+        pAcc->negative = FALSE;
+        pAcc->limbCount = 0;
+    }
+}
+
+
+/**
+ * @brief  initialises an accumulator to zero.
+ * @note   no memory is allocated until the value outgrows a long.
+ * @param  pAcc: accumulator to initialise (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval None
+ */
+void initAccumulator( Accumulator* pAcc ) {
+    pAcc->small = 0;
+    pAcc->isBig = FALSE;
+    pAcc->negative = FALSE;
+    pAcc->pulLimbs = NULL;
+    pAcc->limbCount = 0;
+    pAcc->limbCapacity = 0;
+}
+
+
+/**
+ * @brief  adds a value to the accumulator without ever overflowing.
+ * @note   while the total fits in a long this is one overflow check and one addition. A total that would overflow is 
+ * * promoted to base 10^9 limbs and carries on with limb-wise addition or subtraction, returning to the long when it fits.
+ * @param  pAcc: accumulator to add to (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  value: value to add, negative to subtract (Type: Long).
+ * @retval None
+ */
+void addAccumulator( Accumulator* pAcc, long value ) {
+    unsigned long aulValue[MAX_LONG_LIMBS];
+    unsigned long* pulLimbs;
+    unsigned long carry = 0, limb, other;
+    int valueCount, valueNegative, index, count;
+
+    if ( !pAcc->isBig ) {
+        if ( ( value > 0 && pAcc->small <= LONG_MAX - value ) || ( value <= 0 && pAcc->small >= LONG_MIN - value ) ) {
+            pAcc->small += value; /* fast path, no overflow */
+            return;
+        }
+        if ( !promote( pAcc ) ) {
+            return;
+        }
+    }
+
+    valueCount = splitLong( value, aulValue, &valueNegative );
+
+    if ( valueNegative == pAcc->negative ) { /* same sign, magnitudes add */
+        count = ( pAcc->limbCount > valueCount ) ? pAcc->limbCount : valueCount;
+        if ( !reserveLimbs( pAcc, count + 1 ) ) {
+            return;
+        }
+        pulLimbs = pAcc->pulLimbs;
+
+        for ( index = 0 ; index < count || carry ; index++ ) {
+            limb = ( index < pAcc->limbCount ) ? pulLimbs[index] : 0;
+            other = ( index < valueCount ) ? aulValue[index] : 0;
+            limb += other + carry;
+            carry = ( limb >= ACCUMULATOR_LIMB_BASE );
+            pulLimbs[index] = carry ? limb - ACCUMULATOR_LIMB_BASE : limb;
+        }
+
+        if ( index > pAcc->limbCount ) {
+            pAcc->limbCount = index;
+        }
+    }
+
+    else if ( compareMagnitude( pAcc->pulLimbs, pAcc->limbCount, aulValue, valueCount ) >= 0 ) { /* |total| shrinks */
+        pulLimbs = pAcc->pulLimbs;
+
+        for ( index = 0 ; index < pAcc->limbCount ; index++ ) {
+            other = ( ( index < valueCount ) ? aulValue[index] : 0 ) + carry;
+            carry = ( pulLimbs[index] < other );
+            pulLimbs[index] = carry ? pulLimbs[index] + ACCUMULATOR_LIMB_BASE - other : pulLimbs[index] - other;
+        }
+    }
+
+    else { /* value is larger than the total with the opposite sign, the sign flips */
+        if ( !reserveLimbs( pAcc, valueCount ) ) {
+            return;
+        }
+        pulLimbs = pAcc->pulLimbs;
+
+        for ( index = 0 ; index < valueCount ; index++ ) {
+            other = ( ( index < pAcc->limbCount ) ? pulLimbs[index] : 0 ) + carry;
+            carry = ( aulValue[index] < other );
+            pulLimbs[index] = carry ? aulValue[index] + ACCUMULATOR_LIMB_BASE - other : aulValue[index] - other;
+        }
+
+        pAcc->limbCount = valueCount;
+        pAcc->negative = valueNegative;
+    }
+
+    normalise( pAcc );
+}
+
+
+/**
+ * @brief  checks if the accumulator holds zero.
+ * @param  pAcc: accumulator to check (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns TRUE if the value is zero.
+ */
+int accumulatorIsZero( const Accumulator* pAcc ) {
+    return !pAcc->isBig && pAcc->small == 0;
+}
+
+
+/**
+ * @brief  compares the values of two accumulators.
+ * @param  pAccA: first accumulator (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  pAccB: second accumulator (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns -1, 0 or 1 as A is smaller, equal or larger than B.
+ */
+int compareAccumulator( const Accumulator* pAccA, const Accumulator* pAccB ) {
+    unsigned long aulA[MAX_LONG_LIMBS], aulB[MAX_LONG_LIMBS];
+    const unsigned long* pulA = aulA;
+    const unsigned long* pulB = aulB;
+    int countA, countB, negativeA, negativeB, cmp;
+
+    if ( !pAccA->isBig && !pAccB->isBig ) {
+        return ( pAccA->small < pAccB->small ) ? -1 : ( pAccA->small > pAccB->small );
+    }
+
+    if ( pAccA->isBig ) {
+        pulA = pAccA->pulLimbs; countA = pAccA->limbCount; negativeA = pAccA->negative;
+    }
+    else {
+        countA = splitLong( pAccA->small, aulA, &negativeA );
+    }
+
+    if ( pAccB->isBig ) {
+        pulB = pAccB->pulLimbs; countB = pAccB->limbCount; negativeB = pAccB->negative;
+    }
+    else {
+        countB = splitLong( pAccB->small, aulB, &negativeB );
+    }
+
+    if ( negativeA != negativeB ) {
+        return negativeA ? -1 : 1;
+    }
+
+    cmp = compareMagnitude( pulA, countA, pulB, countB );
+    return negativeA ? -cmp : cmp;
+}
+
+
+/**
+ * @brief  copies the value of one accumulator into another.
+ * @param  pDest: initialised accumulator to overwrite (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  pSrc: accumulator to copy (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval None
+ */
+void copyAccumulator( Accumulator* pDest, const Accumulator* pSrc ) {
+    pDest->small = pSrc->small;
+    pDest->isBig = pSrc->isBig;
+    pDest->negative = pSrc->negative;
+    pDest->limbCount = 0;
+
+    if ( pSrc->isBig && reserveLimbs( pDest, pSrc->limbCount ) ) {
+        memcpy( pDest->pulLimbs, pSrc->pulLimbs, sizeof( unsigned long ) * ( size_t ) pSrc->limbCount );
+        pDest->limbCount = pSrc->limbCount;
+    }
+}
+
+
+/**
+ * @brief  returns the amount of characters the value takes in decimal.
+ * @param  pAcc: accumulator to measure (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns the length including a leading '-' if negative.
+ */
+size_t accumulatorLength( const Accumulator* pAcc ) {
+    char acText[32];
+    unsigned long top;
+    size_t length;
+
+    if ( !pAcc->isBig ) {
+        return ( size_t ) sprintf( acText, "%ld", pAcc->small );
+    }
+
+    length = ( size_t ) ( pAcc->limbCount - 1 ) * ACCUMULATOR_LIMB_DIGITS + ( pAcc->negative ? 1 : 0 );
+    for ( top = pAcc->pulLimbs[pAcc->limbCount - 1] ; top > 0 ; top /= 10 ) {
+        length++;
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief  writes the value in decimal.
+ * @note   no terminating '\0' is written, pcDest must hold accumulatorLength() characters.
+ * @param  pAcc: accumulator to format (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  pcDest: destination buffer (Type: Char array).
+ * @retval returns the amount of characters written.
+ */
+size_t formatAccumulator( const Accumulator* pAcc, char* pcDest ) {
+    char acText[32];
+    size_t length = 0, partLength;
+    int index;
+
+    if ( !pAcc->isBig ) {
+        length = ( size_t ) sprintf( acText, "%ld", pAcc->small );
+        memcpy( pcDest, acText, length );
+        return length;
+    }
+
+    if ( pAcc->negative ) {
+        pcDest[length++] = '-';
+    }
+
+    /* most significant limb unpadded, every other limb padded to 9 digits */
+    for ( index = pAcc->limbCount - 1 ; index >= 0 ; index-- ) {
+        partLength = ( size_t ) sprintf( acText, ( index == pAcc->limbCount - 1 ) ? "%lu" : "%09lu", pAcc->pulLimbs[index] );
+        memcpy( pcDest + length, acText, partLength );
+        length += partLength;
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief  prints the value in decimal to a file.
+ * @param  pFile: file to print to (Type: Pointer to the type 'FILE').
+ * @param  pAcc: accumulator to print (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval None
+ */
+void printAccumulator( FILE* pFile, const Accumulator* pAcc ) {
+    int index;
+
+    if ( !pAcc->isBig ) {
+        fprintf( pFile, "%ld", pAcc->small );
+        return;
+    }
+
+    fprintf( pFile, pAcc->negative ? "-%lu" : "%lu", pAcc->pulLimbs[pAcc->limbCount - 1] );
+    for ( index = pAcc->limbCount - 2 ; index >= 0 ; index-- ) {
+        fprintf( pFile, "%09lu", pAcc->pulLimbs[index] );
+    }
+}
+
+
+/**
+ * @brief  frees the limbs of an accumulator and resets it to zero.
+ * @param  pAcc: accumulator to free (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval None
+ */
+void freeAccumulator( Accumulator* pAcc ) {
+    free( pAcc->pulLimbs );
+    initAccumulator( pAcc );
+}
@@ -0,0 +1,31 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define ACCUMULATOR_LIMB_BASE 1000000000UL /* bignum limbs hold 9 decimal digits each */
+#define ACCUMULATOR_LIMB_DIGITS 9
+
+typedef struct Accumulator
+{
+	long small; /* value while it fits in a long, the common case */
+	int isBig; /* TRUE once the value has been promoted to limbs */
+	int negative; /* sign of the promoted value */
+	unsigned long* pulLimbs; /* magnitude of the promoted value, least significant limb first */
+	int limbCount; /* limbs in use */
+	int limbCapacity; /* limbs allocated */
+} Accumulator;
+
+
+void initAccumulator( Accumulator* pAcc );
+void addAccumulator( Accumulator* pAcc, long value );
+int accumulatorIsZero( const Accumulator* pAcc );
+int compareAccumulator( const Accumulator* pAccA, const Accumulator* pAccB );
+void copyAccumulator( Accumulator* pDest, const Accumulator* pSrc );
+size_t accumulatorLength( const Accumulator* pAcc );
+size_t formatAccumulator( const Accumulator* pAcc, char* pcDest );
+void printAccumulator( FILE* pFile, const Accumulator* pAcc );
+void freeAccumulator( Accumulator* pAcc );
+
+#endif
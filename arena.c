@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/* block headers are padded so the first allocation in a block is aligned */
+#define HEADER_SIZE ( ( sizeof( ArenaBlock ) + ARENA_ALIGNMENT - 1 ) & ~( size_t ) ( ARENA_ALIGNMENT - 1 ) )
+
+/* sizes are rounded up to ARENA_ALIGNMENT, so each multiple of it is one size class */
+#define ROUND_SIZE( size ) ( ( ( size ) + ARENA_ALIGNMENT - 1 ) & ~( size_t ) ( ARENA_ALIGNMENT - 1 ) )
+
+
+/**
+ * @brief  creates an arena that carves small allocations out of large blocks.
+ * @note   no block is malloc'ed until the first allocation. Everything carved from the arena is released at once by freeArena; 
+ * * small allocations handed back earlier with arenaRelease are reused instead of carving new memory.
+ * @param  blockSize: usable bytes in each block, ARENA_DEFAULT_BLOCK_SIZE is used if 0 (Type: size_t).
+ * @retval Returns Arena Struct.
+ */
+Arena* createArena( size_t blockSize ) {
+    Arena* pArena = ( Arena* ) malloc( sizeof( Arena ) );
+    pArena->pBlocks = NULL;
+    pArena->blockSize = ( blockSize > 0 ) ? blockSize : ARENA_DEFAULT_BLOCK_SIZE;
+    pArena->bytesReserved = 0;
+    pArena->bytesUsed = 0;
+    memset( pArena->apFree, 0, sizeof( pArena->apFree ) );
+
+    return pArena;
+}
+
+
+/**
+ * @brief  allocates memory from the arena.
+ * @note   sizes are rounded up to ARENA_ALIGNMENT. An allocation of the same rounded size released with arenaRelease is 
+ * * reused first. Otherwise a new block is malloc'ed when the current one is full, requests larger than the block size get 
+ * * a block of their own.
+ * @param  pArena: arena to allocate from (Type: Pointer to a type defined struct called "Arena").
+ * @param  size: amount of bytes needed (Type: size_t).
+ * @retval returns a pointer to the memory, NULL if malloc failed.
+ */
+void* arenaAlloc( Arena* pArena, size_t size ) {
+    ArenaBlock* pBlock = pArena->pBlocks;
+    size_t capacity;
+    void* retVal = NULL;
+
+    size = ROUND_SIZE( size ); /* round up to keep the next allocation aligned */
+
+    if ( size > 0 && size / ARENA_ALIGNMENT <= ARENA_SIZE_CLASSES && pArena->apFree[size / ARENA_ALIGNMENT - 1] != NULL ) {
+        retVal = pArena->apFree[size / ARENA_ALIGNMENT - 1];
+        pArena->apFree[size / ARENA_ALIGNMENT - 1] = *( void** ) retVal;
+        pArena->bytesUsed += size;
+        return retVal;
+    }
+
+    if ( pBlock == NULL || pBlock->capacity - pBlock->used < size ) { /* current block cannot hold the request */
+        capacity = ( size > pArena->blockSize ) ? size : pArena->blockSize;
+        pBlock = ( ArenaBlock* ) malloc( HEADER_SIZE + capacity );
+
+        if ( pBlock != NULL ) {
+            pBlock->next = pArena->pBlocks;
+            pBlock->used = 0;
+            pBlock->capacity = capacity;
+            pArena->pBlocks = pBlock;
+            pArena->bytesReserved += capacity;
+        }
+    }
+
+    if ( pBlock != NULL ) {
+        retVal = ( char* ) pBlock + HEADER_SIZE + pBlock->used;
+        pBlock->used += size;
+        pArena->bytesUsed += size;
+    }
+
+    return retVal;
+}
+
+
+/**
+ * @brief  hands an allocation back to the arena for reuse by a later arenaAlloc of the same rounded size.
+ * @note   the memory stays in the arena's blocks, linked into the free list of its size class. Allocations larger than 
+ * * ARENA_SIZE_CLASSES * ARENA_ALIGNMENT bytes are not kept and stay unused until freeArena.
+ * @param  pArena: arena the memory was allocated from (Type: Pointer to a type defined struct called "Arena").
+ * @param  pMemory: memory returned by arenaAlloc, may be NULL (Type: Void Pointer).
+ * @param  size: size that was passed to arenaAlloc (Type: size_t).
+ * @retval None
+ */
+void arenaRelease( Arena* pArena, void* pMemory, size_t size ) {
+    size = ROUND_SIZE( size );
+
+    if ( pMemory != NULL && size > 0 && size / ARENA_ALIGNMENT <= ARENA_SIZE_CLASSES ) {
+        *( void** ) pMemory = pArena->apFree[size / ARENA_ALIGNMENT - 1];
+        pArena->apFree[size / ARENA_ALIGNMENT - 1] = pMemory;
+        pArena->bytesUsed -= size;
+    }
+}
+
+
+/**
+ * @brief  frees the arena and every allocation carved from it.
+ * @param  pArena: arena to free (Type: Pointer to a type defined struct called "Arena").
+ * @retval None
+ */
+void freeArena( Arena* pArena ) {
+    ArenaBlock* pBlock;
+    ArenaBlock* pTemp;
+
+    if ( pArena != NULL ) {
+        pBlock = pArena->pBlocks;
+
+        while ( pBlock ) { /* free every block */
+            pTemp = pBlock->next;
+            free( pBlock );
+            pBlock = pTemp;
+        }
+
+        free( pArena );
+    }
+}
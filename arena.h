@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+#define ARENA_SIZE_CLASSES 16 /* released allocations up to ARENA_SIZE_CLASSES * ARENA_ALIGNMENT bytes are kept for reuse */
+
+typedef struct ArenaBlock
+{
+	struct ArenaBlock* next; /* previously filled block */
+	size_t used; /* bytes handed out from this block */
+	size_t capacity; /* usable bytes in this block */
+} ArenaBlock;
+
+typedef struct Arena
+{
+	ArenaBlock* pBlocks; /* block currently being carved, links to older blocks */
+	size_t blockSize; /* usable bytes requested for each new block */
+	size_t bytesReserved; /* total usable bytes obtained from malloc */
+	size_t bytesUsed; /* total bytes handed out, including alignment padding */
+	void* apFree[ARENA_SIZE_CLASSES]; /* released allocations, one list per rounded size, linked through their first bytes */
+} Arena;
+
+
+Arena* createArena( size_t blockSize );
+void* arenaAlloc( Arena* pArena, size_t size );
+void arenaRelease( Arena* pArena, void* pMemory, size_t size );
+void freeArena( Arena* pArena );
+
+#endif
@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "module.h"
+#include "render.h"
+#include "workload.h"
+
+#define BENCH_DEFAULT_MAX_N 10000000L
+#define BENCH_DEFAULT_SEED 42UL
+#define BENCH_KEY_OPERANDS 65536 /* operands of keystrokes generated up front, replayed cyclically */
+#define BENCH_DISPLAY_MAX_FRAMES 1000000L /* displayCalculator makes ~30 printf calls a frame, keep its runs bounded */
+
+#define BENCH_PATH_LINKED_LIST 0
+#define BENCH_PATH_ARENA_LIST 1
+#define BENCH_PATH_INT_LIST 2
+#define BENCH_PATH_DISPATCH 3
+#define BENCH_PATH_RENDER 4
+#define BENCH_PATH_COUNT 5
+
+
+/* allocation counters, fed by the -Wl,--wrap wrappers below */
+static unsigned long allocCount = 0;
+
+void* __real_malloc( size_t size );
+void* __real_calloc( size_t count, size_t size );
+void* __real_realloc( void* pData, size_t size );
+
+void* __wrap_malloc( size_t size ) {
+    allocCount++;
+    return __real_malloc( size );
+}
+
+void* __wrap_calloc( size_t count, size_t size ) {
+    allocCount++;
+    return __real_calloc( count, size );
+}
+
+void* __wrap_realloc( void* pData, size_t size ) {
+    allocCount++;
+    return __real_realloc( pData, size );
+}
+
+
+/**
+ * @brief  returns a monotonic timestamp in nanoseconds.
+ * @retval returns the timestamp.
+ */
+static double nowNs() {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( double ) now.tv_sec * 1e9 + ( double ) now.tv_nsec;
+}
+
+
+/**
+ * @brief  prints one result as a JSON line.
+ * @note   peak RSS is the high-water mark of the process running the path, as reported by getrusage. Every path runs in 
+ * * its own forked child, so it covers that path (and the small parent it was forked from), not the paths before it.
+ * @param  pcName: benchmarked path (Type: Char array).
+ * @param  n: operands in the run (Type: Long).
+ * @param  ops: operations timed (Type: Long).
+ * @param  elapsedNs: time taken by the operations (Type: Double).
+ * @param  allocs: allocations made by the operations (Type: Unsigned Long).
+ * @retval None
+ */
+static void report( const char* pcName, long n, long ops, double elapsedNs, unsigned long allocs ) {
+    struct rusage usage;
+
+    getrusage( RUSAGE_SELF, &usage );
+    printf( "{\"bench\":\"%s\",\"n\":%ld,\"ops\":%ld,\"ns_per_op\":%.2f,\"allocs_per_op\":%.4f,\"peak_rss_kb\":%ld}\n", 
+            pcName, n, ops, elapsedNs / ( double ) ops, ( double ) allocs / ( double ) ops, ( long ) usage.ru_maxrss );
+    fflush( stdout );
+}
+
+
+/**
+ * @brief  times insertLast, removeLast and freeLinkedList with malloc'ed and arena-backed lists.
+ * @retval None
+ */
+static void benchLinkedList( long n, unsigned long* pulSeed, int useArena ) {
+    LinkedList* pList;
+    int* piData;
+    long index;
+    double start;
+    unsigned long allocs;
+
+    pList = useArena ? createLinkedListWithArena( ARENA_DEFAULT_BLOCK_SIZE ) : createLinkedList();
+
+    allocs = allocCount;
+    start = nowNs();
+    for ( index = 0 ; index < n ; index++ ) {
+        piData = ( int* ) allocLinkedListData( pList, sizeof( int ) );
+        *piData = randomOperand( pulSeed );
+        insertLast( pList, piData );
+    }
+    report( useArena ? "linkedList.arena.insertLast" : "linkedList.insertLast", n, n, nowNs() - start, allocCount - allocs );
+
+    allocs = allocCount;
+    start = nowNs();
+    while ( pList->size > n / 2 ) {
+        releaseLinkedListData( pList, removeLast( pList ), sizeof( int ), &freeData );
+    }
+    report( useArena ? "linkedList.arena.removeLast" : "linkedList.removeLast", n, n - n / 2, nowNs() - start, allocCount - allocs );
+
+    start = nowNs();
+    index = pList->size;
+    freeLinkedList( pList, &freeData );
+    report( useArena ? "linkedList.arena.freeLinkedList" : "linkedList.freeLinkedList", n, index > 0 ? index : 1, nowNs() - start, 0 );
+}
+
+
+/**
+ * @brief  times insertLastInt and removeLastInt on the unrolled operand list.
+ * @retval None
+ */
+static void benchIntList( long n, unsigned long* pulSeed ) {
+    IntList* pList = createIntList();
+    long index;
+    double start;
+    unsigned long allocs;
+
+    allocs = allocCount;
+    start = nowNs();
+    for ( index = 0 ; index < n ; index++ ) {
+        insertLastInt( pList, randomOperand( pulSeed ) );
+    }
+    report( "intList.insertLastInt", n, n, nowNs() - start, allocCount - allocs );
+
+    allocs = allocCount;
+    start = nowNs();
+    while ( removeLastInt( pList, NULL ) ) {
+    }
+    report( "intList.removeLastInt", n, n, nowNs() - start, allocCount - allocs );
+
+    freeIntList( pList );
+}
+
+
+/**
+ * @brief  times userInterfaceManager over the keystrokes of n operands, then writeDataToFile over the resulting history.
+ * @note   keystrokes for BENCH_KEY_OPERANDS operands are generated up front and replayed cyclically.
+ * @retval None
+ */
+static void benchDispatch( long n, const char* pcKeys, size_t keyCount, long keyOperands ) {
+    Session session;
+    FILE* pNull;
+    long cycles, cycle, ops;
+    size_t index;
+    double start;
+    unsigned long allocs;
+
+    initSession( &session, 0 );
+    cycles = ( n + keyOperands - 1 ) / keyOperands;
+    ops = 0;
+
+    allocs = allocCount;
+    start = nowNs();
+    for ( cycle = 0 ; cycle < cycles ; cycle++ ) {
+        for ( index = 0 ; index < keyCount && session.pList->size < n ; index++ ) {
+            userInterfaceManager( &session, ( char* ) &pcKeys[index] );
+            ops++;
+        }
+    }
+    report( "userInterfaceManager", n, ops, nowNs() - start, allocCount - allocs );
+
+    pNull = fopen( "/dev/null", "w" );
+    allocs = allocCount;
+    start = nowNs();
+    writeDataToFile( session.pList, pNull, &session.total );
+    fflush( pNull );
+    report( "writeDataToFile", n, n, nowNs() - start, allocCount - allocs );
+    fclose( pNull );
+
+    freeSession( &session );
+}
+
+
+/**
+ * @brief  times renderCalculator and displayCalculator, one frame per keystroke, drawn to /dev/null.
+ * @retval None
+ */
+static void benchRender( long frames, const char* pcKeys, size_t keyCount ) {
+    Session session;
+    Renderer* pRenderer;
+    int nullFd, savedStdout;
+    long frame;
+    double start, elapsed = 0;
+    unsigned long allocs;
+
+    initSession( &session, 0 );
+    nullFd = open( "/dev/null", O_WRONLY );
+    pRenderer = createRenderer( nullFd );
+
+    allocs = allocCount;
+    for ( frame = 0 ; frame < frames ; frame++ ) {
+        userInterfaceManager( &session, ( char* ) &pcKeys[( size_t ) frame % keyCount] );
+        start = nowNs();
+        renderCalculator( pRenderer, &session );
+        elapsed += nowNs() - start;
+    }
+    report( "renderCalculator", frames, frames, elapsed, allocCount - allocs );
+    freeRenderer( pRenderer );
+
+    if ( frames <= BENCH_DISPLAY_MAX_FRAMES ) {
+        fflush( stdout );
+        savedStdout = dup( STDOUT_FILENO );
+        dup2( nullFd, STDOUT_FILENO );
+
+        elapsed = 0;
+        allocs = allocCount;
+        for ( frame = 0 ; frame < frames ; frame++ ) {
+            userInterfaceManager( &session, ( char* ) &pcKeys[( size_t ) frame % keyCount] );
+            start = nowNs();
+            displayCalculator( &session );
+            elapsed += nowNs() - start;
+        }
+        fflush( stdout );
+        allocs = allocCount - allocs;
+
+        dup2( savedStdout, STDOUT_FILENO );
+        close( savedStdout );
+        report( "displayCalculator", frames, frames, elapsed, allocs );
+    }
+
+    close( nullFd );
+    freeSession( &session );
+}
+
+
+/**
+ * @brief  runs one benchmarked path at one scale, its operands generated from the seed.
+ * @retval None
+ */
+static void runPath( int path, long n, unsigned long seed, const char* pcKeys, size_t keyCount ) {
+    unsigned long state = seed;
+
+    switch ( path ) {
+        case BENCH_PATH_LINKED_LIST:
+            benchLinkedList( n, &state, 0 );
+            break;
+        case BENCH_PATH_ARENA_LIST:
+            benchLinkedList( n, &state, 1 );
+            break;
+        case BENCH_PATH_INT_LIST:
+            benchIntList( n, &state );
+            break;
+        case BENCH_PATH_DISPATCH:
+            benchDispatch( n, pcKeys, keyCount, BENCH_KEY_OPERANDS );
+            break;
+        default:
+            benchRender( n, pcKeys, keyCount );
+            break;
+    }
+}
+
+
+int main( int argc, char *argv[] ) {
+    long maxN = BENCH_DEFAULT_MAX_N;
+    unsigned long seed = BENCH_DEFAULT_SEED;
+    unsigned long state;
+    long n, operand;
+    int path;
+    pid_t child;
+    int cursorKey = KEYBOARD_START_KEY;
+    size_t keyCount = 0;
+    char* pcKeys;
+    Keyboard keyboard;
+
+    if ( argc > 1 ) {
+        maxN = atol( argv[1] );
+    }
+    if ( argc > 2 ) {
+        seed = strtoul( argv[2], NULL, 10 );
+    }
+    if ( maxN < 10 || seed == 0 ) {
+        printf( "Please provide argument correctly: ./calculator_bench [maxOperands >= 10] [seed > 0]\n" );
+        return 1;
+    }
+
+    constructKeyboard( &keyboard, 0 );
+
+    /* seeded synthetic keystrokes for BENCH_KEY_OPERANDS operands */
+    state = seed;
+    pcKeys = ( char* ) malloc( ( size_t ) BENCH_KEY_OPERANDS * WORKLOAD_MAX_KEYS_PER_OPERAND + KEYBOARD_ROWS + KEYBOARD_COLS );
+    for ( operand = 0 ; operand < BENCH_KEY_OPERANDS ; operand++ ) {
+        keyCount += keysForOperand( &keyboard, &cursorKey, randomOperand( &state ), pcKeys + keyCount );
+    }
+
+    /* back to the start key, so every cycle through the keys enters the same operands (moves stop at the edges) */
+    for ( operand = 0 ; operand < KEYBOARD_ROWS ; operand++ ) {
+        pcKeys[keyCount++] = 'w';
+    }
+    for ( operand = 0 ; operand < KEYBOARD_COLS ; operand++ ) {
+        pcKeys[keyCount++] = 'a';
+    }
+
+    /* one child per path and scale, so each peak_rss_kb is that path's own; without fork the path runs here */
+    for ( n = 10 ; n <= maxN ; n *= 10 ) {
+        for ( path = 0 ; path < BENCH_PATH_COUNT ; path++ ) {
+            fflush( stdout );
+
+            if ( ( child = fork() ) == 0 ) {
+                runPath( path, n, seed, pcKeys, keyCount );
+                fflush( stdout );
+                _exit( 0 );
+            }
+
+            if ( child < 0 ) {
+                runPath( path, n, seed, pcKeys, keyCount );
+            }
+            else {
+                waitpid( child, NULL, 0 );
+            }
+        }
+    }
+
+    free( pcKeys );
+    return 0;
+}
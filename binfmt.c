@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "binfmt.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+#define CRC32_POLYNOMIAL 0xEDB88320UL /* reflected IEEE 802.3, as used by zlib and PNG */
+
+static unsigned long crcTable[256];
+static int crcTableBuilt = FALSE;
+
+
+/**
+ * @brief  fills the byte-at-a-time CRC32 table.
+ * @note   built on first use; call crc32Update once before sharing it between threads.
+ * @retval None
+ */
+static void buildCrcTable() {
+    unsigned long crc;
+    int byte, bit;
+
+    for ( byte = 0 ; byte < 256 ; byte++ ) {
+        crc = ( unsigned long ) byte;
+        for ( bit = 0 ; bit < 8 ; bit++ ) {
+            crc = ( crc & 1 ) ? ( crc >> 1 ) ^ CRC32_POLYNOMIAL : crc >> 1;
+        }
+        crcTable[byte] = crc;
+    }
+
+    crcTableBuilt = TRUE;
+}
+
+
+/**
+ * @brief  continues a CRC32 over more bytes.
+ * @note   start with 0xFFFFFFFF and invert the result (crc ^ 0xFFFFFFFF) once every byte has been added.
+ * @param  crc: CRC of the bytes so far (Type: Unsigned Long).
+ * @param  pData: bytes to add (Type: Unsigned Char array).
+ * @param  length: amount of bytes (Type: size_t).
+ * @retval returns the updated CRC.
+ */
+unsigned long crc32Update( unsigned long crc, const unsigned char* pData, size_t length ) {
+    if ( !crcTableBuilt ) {
+        buildCrcTable();
+    }
+
+    while ( length-- > 0 ) {
+        crc = crcTable[( crc ^ *pData++ ) & 0xFF] ^ ( ( crc >> 8 ) & 0xFFFFFFUL );
+    }
+
+    return crc & 0xFFFFFFFFUL;
+}
+
+
+/**
+ * @brief  maps a signed value to an unsigned one so small magnitudes of either sign encode to short varints.
+ * @retval returns 0, -1, 1, -2, 2 ... as 0, 1, 2, 3, 4 ...
+ */
+static unsigned long zigzagEncode( long value ) {
+    return value >= 0 ? ( unsigned long ) value << 1 : ( ( unsigned long ) ( -( value + 1 ) ) << 1 ) | 1;
+}
+
+
+/**
+ * @brief  reverses zigzagEncode.
+ * @retval returns the signed value.
+ */
+static long zigzagDecode( unsigned long value ) {
+    return ( value & 1 ) ? -( long ) ( value >> 1 ) - 1 : ( long ) ( value >> 1 );
+}
+
+
+/**
+ * @brief  hands the queued bytes to the file and folds them into the running CRC.
+ * @retval None
+ */
+static void flushWriter( BinWriter* pWriter ) {
+    pWriter->crc = crc32Update( pWriter->crc, pWriter->acBuffer, pWriter->length );
+    fwrite( pWriter->acBuffer, 1, pWriter->length, pWriter->pFile );
+    pWriter->length = 0;
+}
+
+
+/**
+ * @brief  queues raw bytes.
+ * @retval None
+ */
+static void writeBytes( BinWriter* pWriter, const void* pData, size_t length ) {
+    const unsigned char* pucData = ( const unsigned char* ) pData;
+    size_t chunk;
+
+    while ( length > 0 ) {
+        if ( pWriter->length == BINFMT_BUFFER_SIZE ) {
+            flushWriter( pWriter );
+        }
+
+        chunk = BINFMT_BUFFER_SIZE - pWriter->length < length ? BINFMT_BUFFER_SIZE - pWriter->length : length;
+        memcpy( pWriter->acBuffer + pWriter->length, pucData, chunk );
+        pWriter->length += chunk;
+        pucData += chunk;
+        length -= chunk;
+    }
+}
+
+
+/**
+ * @brief  queues an unsigned LEB128 varint, 7 bits per byte with the high bit set on all but the last.
+ * @retval None
+ */
+static void writeVarint( BinWriter* pWriter, unsigned long value ) {
+    unsigned char* pucOut;
+
+    if ( BINFMT_BUFFER_SIZE - pWriter->length < BINFMT_MAX_VARINT_BYTES ) {
+        flushWriter( pWriter );
+    }
+
+    pucOut = pWriter->acBuffer + pWriter->length;
+
+    while ( value >= 0x80 ) {
+        *pucOut++ = ( unsigned char ) ( value | 0x80 );
+        value >>= 7;
+    }
+    *pucOut++ = ( unsigned char ) value;
+
+    pWriter->length = ( size_t ) ( pucOut - pWriter->acBuffer );
+}
+
+
+/**
+ * @brief  Writes a session as one binary record: the operands in the order they were entered and the total.
+ * @note   Layout: "CALCBIN", a version byte, the operand count as a varint, each operand as a zigzag varint, a tag byte 
+ * * then the total (a zigzag varint while it fits a long, otherwise a varint length and its decimal digits), and finally 
+ * * the CRC32 of all of the above, little endian. Calculator operands take at most 4 bytes each. Records can be 
+ * * concatenated; calcconv converts them back to the text format of writeDataToFile.
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
+ * @param  pOutFile: output file opened in binary mode (Type: Pointer to the type 'FILE').
+ * @param  pCurrTotal: total of the operands (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns TRUE if the record was handed to the file without error.
+ */
+int writeBinaryFile( IntList* pList, FILE* pOutFile, const Accumulator* pCurrTotal ) {
+    BinWriter* pWriter = ( BinWriter* ) malloc( sizeof( BinWriter ) );
+    IntListIterator iter;
+    unsigned char acChecksum[BINFMT_CHECKSUM_SIZE];
+    unsigned char tag, version = BINFMT_VERSION;
+    unsigned long crc;
+    char* pcDigits;
+    size_t digitCount;
+    int value, index, ok;
+
+    pWriter->pFile = pOutFile;
+    pWriter->crc = 0xFFFFFFFFUL;
+    pWriter->length = 0;
+
+    writeBytes( pWriter, BINFMT_MAGIC, BINFMT_MAGIC_SIZE );
+    writeBytes( pWriter, &version, 1 );
+    writeVarint( pWriter, ( unsigned long ) pList->size );
+
+    startIntListIterator( pList, &iter );
+    while ( nextInt( &iter, &value ) ) {
+        writeVarint( pWriter, zigzagEncode( value ) );
+    }
+
+    if ( !pCurrTotal->isBig ) {
+        tag = BINFMT_TOTAL_VARINT;
+        writeBytes( pWriter, &tag, 1 );
+        writeVarint( pWriter, zigzagEncode( pCurrTotal->small ) );
+    }
+    else {
+        pcDigits = ( char* ) malloc( accumulatorLength( pCurrTotal ) );
+        digitCount = formatAccumulator( pCurrTotal, pcDigits );
+
+        tag = BINFMT_TOTAL_DECIMAL;
+        writeBytes( pWriter, &tag, 1 );
+        writeVarint( pWriter, ( unsigned long ) digitCount );
+        writeBytes( pWriter, pcDigits, digitCount );
+        free( pcDigits );
+    }
+
+    flushWriter( pWriter );
+
+    crc = pWriter->crc ^ 0xFFFFFFFFUL;
+    for ( index = 0 ; index < BINFMT_CHECKSUM_SIZE ; index++ ) {
+        acChecksum[index] = ( unsigned char ) ( crc >> ( 8 * index ) );
+    }
+    fwrite( acChecksum, 1, BINFMT_CHECKSUM_SIZE, pOutFile );
+
+    ok = !ferror( pOutFile ) && !iter.failed;
+    free( pWriter );
+    return ok;
+}
+
+
+/**
+ * @brief  reads an unsigned LEB128 varint.
+ * @retval returns the amount of bytes used, 0 if the data ends first or the varint is longer than 64 bits.
+ */
+static size_t readVarint( const unsigned char* pData, const unsigned char* pEnd, unsigned long* pulValue ) {
+    const unsigned char* pByte = pData;
+    unsigned long value = 0;
+    int shift = 0;
+
+    while ( pByte < pEnd && shift < 7 * BINFMT_MAX_VARINT_BYTES ) {
+        value |= ( unsigned long ) ( *pByte & 0x7F ) << shift;
+
+        if ( !( *pByte++ & 0x80 ) ) {
+            *pulValue = value;
+            return ( size_t ) ( pByte - pData );
+        }
+        shift += 7;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief  Decodes one record written by writeBinaryFile.
+ * @note   The checksum is verified before anything is decoded, then every operand is appended to pList and added to 
+ * * pTotal and the stored total is checked against that sum.
+ * @param  pData: bytes starting at a record (Type: Unsigned Char array).
+ * @param  length: bytes available from pData (Type: size_t).
+ * @param  pConsumed: receives the size of the record (Type: Pointer to size_t).
+ * @param  pList: empty list the operands are appended to (Type: Pointer to a type defined struct called "IntList").
+ * @param  pTotal: accumulator initialised to 0 that the operands are added to (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns BINFMT_OK, or the BINFMT_ error describing why the record could not be read.
+ */
+int readBinaryRecord( const unsigned char* pData, size_t length, size_t* pConsumed, IntList* pList, Accumulator* pTotal ) {
+    const unsigned char* pByte = pData + BINFMT_HEADER_SIZE;
+    const unsigned char* pEnd = pData + length;
+    unsigned long count, value, index, crc;
+    size_t used;
+    Accumulator stored;
+    char* pcDigits;
+    int tag, retVal = BINFMT_OK;
+
+    if ( length < BINFMT_HEADER_SIZE ) {
+        return length > 0 && memcmp( pData, BINFMT_MAGIC, length < BINFMT_MAGIC_SIZE ? length : BINFMT_MAGIC_SIZE ) == 0 ? BINFMT_TRUNCATED : BINFMT_BAD_HEADER;
+    }
+    if ( memcmp( pData, BINFMT_MAGIC, BINFMT_MAGIC_SIZE ) != 0 || pData[BINFMT_MAGIC_SIZE] != BINFMT_VERSION ) {
+        return BINFMT_BAD_HEADER;
+    }
+
+    /* find the end of the record so the checksum can be verified first */
+    if ( ( used = readVarint( pByte, pEnd, &count ) ) == 0 ) {
+        return BINFMT_TRUNCATED;
+    }
+    pByte += used;
+
+    for ( index = 0 ; index < count ; index++ ) {
+        if ( ( used = readVarint( pByte, pEnd, &value ) ) == 0 ) {
+            return BINFMT_TRUNCATED;
+        }
+        pByte += used;
+    }
+
+    if ( pByte >= pEnd ) {
+        return BINFMT_TRUNCATED;
+    }
+    tag = *pByte++;
+
+    if ( ( used = readVarint( pByte, pEnd, &value ) ) == 0 ) {
+        return BINFMT_TRUNCATED;
+    }
+    pByte += used;
+
+    if ( tag == BINFMT_TOTAL_DECIMAL ) {
+        if ( value > ( unsigned long ) ( pEnd - pByte ) ) {
+            return BINFMT_TRUNCATED;
+        }
+        pByte += value;
+    }
+    else if ( tag != BINFMT_TOTAL_VARINT ) {
+        return BINFMT_BAD_HEADER;
+    }
+
+    if ( pEnd - pByte < BINFMT_CHECKSUM_SIZE ) {
+        return BINFMT_TRUNCATED;
+    }
+
+    crc = crc32Update( 0xFFFFFFFFUL, pData, ( size_t ) ( pByte - pData ) ) ^ 0xFFFFFFFFUL;
+    if ( crc != ( ( unsigned long ) pByte[0] | ( unsigned long ) pByte[1] << 8 | ( unsigned long ) pByte[2] << 16 | ( unsigned long ) pByte[3] << 24 ) ) {
+        return BINFMT_BAD_CHECKSUM;
+    }
+    *pConsumed = ( size_t ) ( pByte - pData ) + BINFMT_CHECKSUM_SIZE;
+
+    /* decode, the record is known to be whole and intact */
+    pByte = pData + BINFMT_HEADER_SIZE;
+    pByte += readVarint( pByte, pEnd, &count );
+
+    for ( index = 0 ; index < count && retVal == BINFMT_OK ; index++ ) {
+        if ( *pByte < 0x80 ) { /* one byte operand, 0 to 63 in magnitude */
+            value = *pByte++;
+        }
+        else {
+            pByte += readVarint( pByte, pEnd, &value );
+        }
+
+        if ( value > 0xFFFFFFFFUL ) {
+            retVal = BINFMT_BAD_OPERAND;
+        }
+        else {
+            insertLastInt( pList, ( int ) zigzagDecode( value ) );
+            addAccumulator( pTotal, zigzagDecode( value ) );
+        }
+    }
+
+    if ( retVal == BINFMT_OK ) {
+        pByte++; /* tag, already checked */
+        pByte += readVarint( pByte, pEnd, &value );
+
+        if ( tag == BINFMT_TOTAL_VARINT ) {
+            initAccumulator( &stored );
+            addAccumulator( &stored, zigzagDecode( value ) );
+            retVal = compareAccumulator( &stored, pTotal ) == 0 ? BINFMT_OK : BINFMT_BAD_TOTAL;
+            freeAccumulator( &stored );
+        }
+        else {
+            pcDigits = ( char* ) malloc( accumulatorLength( pTotal ) );
+            retVal = ( value == formatAccumulator( pTotal, pcDigits ) && memcmp( pcDigits, pByte, value ) == 0 ) ? BINFMT_OK : BINFMT_BAD_TOTAL;
+            free( pcDigits );
+        }
+    }
+
+    return retVal;
+}
+
+
+/**
+ * @brief  describes a readBinaryRecord result.
+ * @retval returns a static message.
+ */
+const char* binaryErrorString( int error ) {
+    switch ( error ) {
+        case BINFMT_OK: return "ok";
+        case BINFMT_TRUNCATED: return "record is truncated";
+        case BINFMT_BAD_HEADER: return "not a calculator record, or an unknown version";
+        case BINFMT_BAD_CHECKSUM: return "checksum mismatch";
+        case BINFMT_BAD_OPERAND: return "operand out of range";
+        case BINFMT_BAD_TOTAL: return "stored total is not the sum of the operands";
+    }
+    return "unknown error";
+}
@@ -0,0 +1,42 @@
+#ifndef BINFMT_H
+#define BINFMT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "intList.h"
+#include "accumulator.h"
+
+#define BINFMT_MAGIC "CALCBIN"
+#define BINFMT_MAGIC_SIZE 7
+#define BINFMT_VERSION 1
+#define BINFMT_HEADER_SIZE ( BINFMT_MAGIC_SIZE + 1 ) /* magic then version byte */
+#define BINFMT_CHECKSUM_SIZE 4
+#define BINFMT_MAX_VARINT_BYTES 10 /* 64 bits, 7 per byte */
+#define BINFMT_BUFFER_SIZE 65536
+
+#define BINFMT_TOTAL_VARINT 0 /* total follows as a zigzag varint */
+#define BINFMT_TOTAL_DECIMAL 1 /* total follows as a varint length then that many decimal characters */
+
+/* readBinaryRecord results */
+#define BINFMT_OK 0
+#define BINFMT_TRUNCATED 1 /* data ends inside the record */
+#define BINFMT_BAD_HEADER 2 /* not a record, or a version this reader does not know */
+#define BINFMT_BAD_CHECKSUM 3 /* CRC32 does not match, the record is corrupt */
+#define BINFMT_BAD_OPERAND 4 /* operand does not fit an int */
+#define BINFMT_BAD_TOTAL 5 /* stored total is not the sum of the operands */
+
+typedef struct BinWriter
+{
+	FILE* pFile;
+	unsigned long crc; /* CRC32 of everything written so far, before the final inversion */
+	size_t length; /* bytes queued in acBuffer */
+	unsigned char acBuffer[BINFMT_BUFFER_SIZE];
+} BinWriter;
+
+
+unsigned long crc32Update( unsigned long crc, const unsigned char* pData, size_t length );
+int writeBinaryFile( IntList* pList, FILE* pOutFile, const Accumulator* pCurrTotal );
+int readBinaryRecord( const unsigned char* pData, size_t length, size_t* pConsumed, IntList* pList, Accumulator* pTotal );
+const char* binaryErrorString( int error );
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "monitor.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+
+/**
+ * @brief  returns a monotonic timestamp in seconds.
+ * @retval returns the timestamp.
+ */
+static double nowSeconds() {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( double ) now.tv_sec + ( double ) now.tv_nsec / 1e9;
+}
+
+
+/**
+ * @brief  prints one snapshot as a line, with the keystroke rate since the previous one.
+ * @retval None
+ */
+static void printSnapshot( const MonitorBlock* pState, double keysPerSecond ) {
+    printf( "pid %ld  layout %ld  operands %ld  total ", pState->pid, pState->layout, pState->operands );
+
+    if ( pState->totalIsBig ) {
+        printf( "(beyond a long)" );
+    }
+    else {
+        printf( "%ld", pState->total );
+    }
+
+    printf( "  display %ld  keys %lu  keys/s %.1f%s\n", pState->currNum, pState->keystrokes, keysPerSecond, 
+            pState->finished ? "  finished" : "" );
+    fflush( stdout );
+}
+
+
+/**
+ * @brief  takes the next snapshot of a calculator's block.
+ * @note   a calculator paused mid-update (i.e. stopped in a debugger) is waited for, one poll interval at a time; one that 
+ * * exited without finishing its session, mid-update or not, is reported.
+ * @retval returns TRUE with the snapshot in pState, FALSE if the calculator is gone.
+ */
+static int readSnapshot( const MonitorBlock* pBlock, MonitorBlock* pState, const struct timespec* pInterval ) {
+    MonitorBlock snapshot;
+    int status;
+
+    while ( ( status = readMonitor( pBlock, &snapshot ) ) == MONITOR_READ_BUSY ) {
+        nanosleep( pInterval, NULL );
+    }
+
+    if ( status == MONITOR_READ_GONE || ( !snapshot.finished && !monitorWriterAlive( snapshot.pid ) ) ) {
+        fprintf( stderr, "Calculator %ld exited without finishing its session\n", pBlock->pid );
+        return FALSE;
+    }
+
+    *pState = snapshot;
+    return TRUE;
+}
+
+
+int main( int argc, char *argv[] ) {
+    const MonitorBlock* pBlock;
+    MonitorBlock state;
+    struct timespec interval;
+    unsigned long lastKeystrokes;
+    long intervalMs = MONITOR_DEFAULT_INTERVAL_MS;
+    double lastTime, now;
+
+    if ( argc > 2 ) {
+        intervalMs = atol( argv[2] );
+    }
+    if ( argc < 2 || argc > 3 || intervalMs <= 0 ) {
+        printf( "Please provide argument correctly: ./calcmon <shmname> [intervalMs]\n" );
+        return 1;
+    }
+
+    if ( ( pBlock = attachMonitor( argv[1] ) ) == NULL ) {
+        fprintf( stderr, "No calculator is publishing to %s (start it with --shm %s)\n", argv[1], argv[1] );
+        return 1;
+    }
+
+    interval.tv_sec = intervalMs / 1000;
+    interval.tv_nsec = ( intervalMs % 1000 ) * 1000000L;
+
+    if ( !readSnapshot( pBlock, &state, &interval ) ) {
+        detachMonitor( pBlock );
+        return 1;
+    }
+    lastKeystrokes = state.keystrokes;
+    lastTime = nowSeconds();
+    printSnapshot( &state, 0.0 );
+
+    /* poll until the session ends or the calculator is gone, the calculator is only probed with signal 0 */
+    while ( !state.finished ) {
+        nanosleep( &interval, NULL );
+
+        if ( !readSnapshot( pBlock, &state, &interval ) ) {
+            detachMonitor( pBlock );
+            return 1;
+        }
+
+        now = nowSeconds();
+        printSnapshot( &state, ( double ) ( state.keystrokes - lastKeystrokes ) / ( now - lastTime ) );
+        lastKeystrokes = state.keystrokes;
+        lastTime = now;
+    }
+
+    detachMonitor( pBlock );
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include "module.h"
+#include "binfmt.h"
+
+
+/**
+ * @brief  parses a decimal int at the start of a string.
+ * @retval returns the character after the number, NULL if there is no number or it does not fit an int.
+ */
+static const char* parseInt( const char* pcText, int* piValue ) {
+    char* pcEnd;
+    long value;
+
+    errno = 0;
+    value = strtol( pcText, &pcEnd, 10 );
+
+    if ( pcEnd == pcText || errno == ERANGE || value < INT_MIN || value > INT_MAX ) {
+        return NULL;
+    }
+
+    *piValue = ( int ) value;
+    return pcEnd;
+}
+
+
+/**
+ * @brief  parses one line of writeDataToFile output into its operands and total.
+ * @note   "c + b + a = total" lists the operands last first; a lone number is the total of at most one operand. The 
+ * * stated total must be exactly the sum, as writeDataToFile would have written it, so the record converts back unchanged.
+ * @retval returns TRUE if the line is a well formed session.
+ */
+static int parseTextLine( const char* pcLine, IntList* pList, Accumulator* pTotal ) {
+    int* piOperands = NULL; /* operands in the order they appear on the line */
+    long count = 0, capacity = 0, index;
+    const char* pcText = pcLine;
+    char* pcDigits;
+    size_t totalLength;
+    int value, ok = TRUE, hasTotal = FALSE;
+
+    while ( ok && !hasTotal ) {
+        if ( ( pcText = parseInt( pcText, &value ) ) == NULL ) {
+            ok = FALSE;
+            break;
+        }
+
+        if ( count == capacity ) {
+            capacity = capacity > 0 ? capacity * 2 : 64;
+            piOperands = ( int* ) realloc( piOperands, sizeof( int ) * ( size_t ) capacity );
+        }
+        piOperands[count++] = value;
+
+        if ( strncmp( pcText, " + ", 3 ) == 0 ) {
+            pcText += 3;
+        }
+        else if ( strncmp( pcText, " = ", 3 ) == 0 ) {
+            pcText += 3;
+            hasTotal = TRUE;
+        }
+        else if ( *pcText == '\0' ) {
+            break;
+        }
+        else {
+            ok = FALSE;
+        }
+    }
+
+    if ( ok && hasTotal ) { /* a sequence of at least two operands */
+        for ( index = count - 1 ; index >= 0 ; index-- ) {
+            insertLastInt( pList, piOperands[index] );
+            addAccumulator( pTotal, piOperands[index] );
+        }
+
+        totalLength = accumulatorLength( pTotal );
+        pcDigits = ( char* ) malloc( totalLength );
+        ok = ( count >= 2 && formatAccumulator( pTotal, pcDigits ) == strlen( pcText ) && memcmp( pcDigits, pcText, totalLength ) == 0 );
+        free( pcDigits );
+    }
+    else if ( ok && count == 1 && piOperands[0] != 0 ) { /* a single operand */
+        insertLastInt( pList, piOperands[0] );
+        addAccumulator( pTotal, piOperands[0] );
+    }
+    else {
+        ok = ok && count == 1; /* a lone 0, no operands */
+    }
+
+    free( piOperands );
+    return ok;
+}
+
+
+/**
+ * @brief  converts every line of a text output file into a binary record.
+ * @param  pcText: the whole file, followed by a NUL (Type: Char array).
+ * @retval returns TRUE if every line converted.
+ */
+static int textToBinary( char* pcText, size_t length, FILE* pOutFile, const char* pcInPath ) {
+    char* pcLine = pcText;
+    char* pcEnd = pcText + length;
+    char* pcNewline;
+    long lineNumber = 0;
+    IntList* pList;
+    Accumulator total;
+    int ok = TRUE;
+
+    while ( ok && pcLine < pcEnd ) {
+        lineNumber++;
+        if ( ( pcNewline = ( char* ) memchr( pcLine, '\n', ( size_t ) ( pcEnd - pcLine ) ) ) == NULL ) {
+            pcNewline = pcEnd; /* last line without a newline, already NUL terminated */
+        }
+        *pcNewline = '\0';
+
+        pList = createIntList();
+        initAccumulator( &total );
+
+        if ( !parseTextLine( pcLine, pList, &total ) ) {
+            fprintf( stderr, "%s:%ld: total does not match or line is malformed\n", pcInPath, lineNumber );
+            ok = FALSE;
+        }
+        else {
+            ok = writeBinaryFile( pList, pOutFile, &total );
+        }
+
+        freeAccumulator( &total );
+        freeIntList( pList );
+        pcLine = pcNewline + 1;
+    }
+
+    return ok;
+}
+
+
+/**
+ * @brief  converts binary records back into the text format of writeDataToFile, one line per record.
+ * @retval returns TRUE if every record converted.
+ */
+static int binaryToText( const unsigned char* pData, size_t length, FILE* pOutFile, const char* pcInPath ) {
+    size_t offset = 0, consumed = 0;
+    IntList* pList;
+    Accumulator total;
+    int error, ok = TRUE;
+
+    while ( ok && offset < length ) {
+        pList = createIntList();
+        initAccumulator( &total );
+
+        if ( ( error = readBinaryRecord( pData + offset, length - offset, &consumed, pList, &total ) ) != BINFMT_OK ) {
+            fprintf( stderr, "%s: byte %lu: %s\n", pcInPath, ( unsigned long ) offset, binaryErrorString( error ) );
+            ok = FALSE;
+        }
+        else {
+            ok = writeDataToFile( pList, pOutFile, &total );
+            offset += consumed;
+        }
+
+        freeAccumulator( &total );
+        freeIntList( pList );
+    }
+
+    return ok;
+}
+
+
+int main( int argc, char *argv[] ) {
+    FILE* pInFile;
+    FILE* pOutFile;
+    unsigned char* pucData = NULL;
+    size_t length = 0, capacity = 0, bytesRead;
+    int ok;
+
+    if ( argc != 3 ) {
+        printf( "Please provide argument correctly: ./calcconv <infile> <outfile>\n" );
+        printf( "Text output files are converted to binary records (--format=bin) and binary records back to text.\n" );
+        return 1;
+    }
+
+    if ( ( pInFile = fopen( argv[1], "rb" ) ) == NULL ) {
+        fprintf( stderr, "Could not open input file: %s\n", argv[1] );
+        return 1;
+    }
+    if ( ( pOutFile = fopen( argv[2], "wb" ) ) == NULL ) {
+        fprintf( stderr, "Could not open output file: %s\n", argv[2] );
+        fclose( pInFile );
+        return 1;
+    }
+
+    /* the whole input is read so it can be decoded straight from memory, with room for a terminating NUL */
+    do {
+        if ( length + 1 >= capacity ) {
+            capacity = capacity > 0 ? capacity * 2 : BINFMT_BUFFER_SIZE;
+            pucData = ( unsigned char* ) realloc( pucData, capacity );
+        }
+        bytesRead = fread( pucData + length, 1, capacity - length, pInFile );
+        length += bytesRead;
+    } while ( bytesRead > 0 );
+    pucData[length] = '\0';
+
+    if ( length >= BINFMT_MAGIC_SIZE && memcmp( pucData, BINFMT_MAGIC, BINFMT_MAGIC_SIZE ) == 0 ) {
+        ok = binaryToText( pucData, length, pOutFile, argv[1] );
+    }
+    else {
+        ok = textToBinary( ( char* ) pucData, length, pOutFile, argv[1] );
+    }
+
+    free( pucData );
+    fclose( pInFile );
+    ok = ( fclose( pOutFile ) == 0 ) && ok;
+
+    return ok ? 0 : 1;
+}
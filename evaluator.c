@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "evaluator.h"
+#include "accumulator.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+#define MAX_OPERAND_DIGITS 18 /* any 18 digit number fits in a 64-bit long */
+#define SWAR_ONES 0x0101010101010101UL
+
+
+/**
+ * @brief  appends bytes to a task's output buffer, growing it as needed.
+ * @note   if realloc fails the task is marked failed and the bytes are dropped, as are those of any later append; 
+ * * evaluateFile then fails the run rather than write an output with lines missing.
+ * @retval None
+ */
+static void appendOut( EvalTask* pTask, const char* pcText, size_t length ) {
+    char* pcOut;
+    size_t capacity;
+
+    if ( pTask->failed ) {
+        return;
+    }
+
+    if ( pTask->outLength + length > pTask->outCapacity ) {
+        capacity = ( pTask->outCapacity > 0 ) ? pTask->outCapacity * 2 : 65536;
+        while ( capacity < pTask->outLength + length ) {
+            capacity *= 2;
+        }
+
+        pcOut = ( char* ) realloc( pTask->pcOut, capacity );
+        if ( pcOut == NULL ) {
+            pTask->failed = TRUE;
+            return;
+        }
+        pTask->pcOut = pcOut;
+        pTask->outCapacity = capacity;
+    }
+
+    memcpy( pTask->pcOut + pTask->outLength, pcText, length );
+    pTask->outLength += length;
+}
+
+
+/**
+ * @brief  remembers a line whose stated total is wrong or that could not be parsed.
+ * @note   if realloc fails the task is marked failed, so the flagged count is never silently short.
+ * @retval None
+ */
+static void flagLine( EvalTask* pTask, long line ) {
+    long* plFlagged;
+    long capacity;
+
+    if ( pTask->flaggedCount == pTask->flaggedCapacity ) {
+        capacity = ( pTask->flaggedCapacity > 0 ) ? pTask->flaggedCapacity * 2 : 64;
+        plFlagged = ( long* ) realloc( pTask->plFlagged, sizeof( long ) * ( size_t ) capacity );
+        if ( plFlagged == NULL ) {
+            pTask->failed = TRUE;
+            return;
+        }
+        pTask->plFlagged = plFlagged;
+        pTask->flaggedCapacity = capacity;
+    }
+
+    pTask->plFlagged[pTask->flaggedCount++] = line;
+}
+
+
+/**
+ * @brief  parses an unsigned run of decimal digits.
+ * @note   on 64-bit little-endian machines eight digits at a time are validated and converted with SWAR arithmetic on 
+ * * a single unsigned long; the remaining digits are parsed one at a time.
+ * @param  ppcText: start of the digits, advanced past them (Type: Pointer to a Char array).
+ * @param  pcEnd: end of the input (Type: Char array).
+ * @param  plValue: receives the value (Type: Pointer to Long).
+ * @retval returns the amount of digits parsed, 0 if there were none or more than MAX_OPERAND_DIGITS.
+ */
+static int parseDigits( const char** ppcText, const char* pcEnd, long* plValue ) {
+    static const unsigned long endianProbe = 1;
+    const char* pcText = *ppcText;
+    unsigned long chunk, value = 0;
+    int digits = 0;
+
+    if ( sizeof( unsigned long ) == 8 && *( const unsigned char* ) &endianProbe == 1 ) {
+        while ( pcEnd - pcText >= 8 && digits + 8 <= MAX_OPERAND_DIGITS ) {
+            memcpy( &chunk, pcText, 8 );
+
+            /* every byte must be in '0'..'9': high nibble 3, and adding 6 must not carry out of the low nibble */
+            if ( ( chunk & ( SWAR_ONES * 0xF0 ) ) != SWAR_ONES * 0x30 || ( ( chunk + SWAR_ONES * 0x06 ) & ( SWAR_ONES * 0xF0 ) ) != SWAR_ONES * 0x30 ) {
+                break;
+            }
+
+            /* combine digit pairs, then pairs of pairs, then the two halves; the first character is the lowest byte */
+            chunk = ( ( chunk & ( SWAR_ONES * 0x0F ) ) * 2561 ) >> 8;
+            chunk = ( ( chunk & 0x00FF00FF00FF00FFUL ) * 6553601 ) >> 16;
+            chunk = ( ( chunk & 0x0000FFFF0000FFFFUL ) * 42949672960001UL ) >> 32;
+
+            value = value * 100000000UL + chunk;
+            digits += 8;
+            pcText += 8;
+        }
+    }
+
+    while ( pcText < pcEnd && *pcText >= '0' && *pcText <= '9' && digits <= MAX_OPERAND_DIGITS ) {
+        value = value * 10 + ( unsigned long ) ( *pcText - '0' );
+        digits++;
+        pcText++;
+    }
+
+    if ( digits == 0 || digits > MAX_OPERAND_DIGITS || ( pcText < pcEnd && *pcText >= '0' && *pcText <= '9' ) ) {
+        return 0;
+    }
+
+    *ppcText = pcText;
+    *plValue = ( long ) value;
+    return digits;
+}
+
+
+/**
+ * @brief  skips spaces, tabs and carriage returns.
+ * @retval returns the first other character's address.
+ */
+static const char* skipBlanks( const char* pcText, const char* pcEnd ) {
+    while ( pcText < pcEnd && ( *pcText == ' ' || *pcText == '\t' || *pcText == '\r' ) ) {
+        pcText++;
+    }
+    return pcText;
+}
+
+
+/**
+ * @brief  re-totals one line in the format of writeDataToFile and appends the result to the task output.
+ * @note   the operands are copied as written and the total is recomputed with an Accumulator. A line with more than one 
+ * * operand gets " = total", a single number is written on its own. Lines that cannot be parsed are copied unchanged.
+ * @param  pTask: task the line belongs to (Type: Pointer to a type defined struct called "EvalTask").
+ * @param  pcLine: first character of the line (Type: Char array).
+ * @param  pcLineEnd: the line's '\n', or the end of the input (Type: Char array).
+ * @retval returns TRUE if the line parsed and its stated total (if any) matched.
+ */
+static int evaluateLine( EvalTask* pTask, const char* pcLine, const char* pcLineEnd ) {
+    const char* pcText = pcLine;
+    const char* pcNumber;
+    const char* pcStated = NULL; /* stated total, after the '=' */
+    size_t statedLength = 0;
+    char acTotal[64];
+    char* pcTotal = acTotal;
+    size_t totalLength;
+    size_t mark = pTask->outLength;
+    Accumulator total;
+    long value;
+    int operands = 0, negative, valid = TRUE, matched = TRUE;
+
+    initAccumulator( &total );
+    pcText = skipBlanks( pcText, pcLineEnd );
+
+    if ( pcText == pcLineEnd ) { /* blank line, keep it */
+        appendOut( pTask, "\n", 1 );
+        return TRUE;
+    }
+
+    while ( valid ) { /* operand ( '+' operand )* */
+        pcNumber = pcText;
+        negative = ( pcText < pcLineEnd && *pcText == '-' );
+        pcText += negative;
+
+        if ( parseDigits( &pcText, pcLineEnd, &value ) == 0 ) {
+            valid = FALSE;
+            break;
+        }
+
+        if ( operands > 0 ) {
+            appendOut( pTask, " + ", 3 );
+        }
+        appendOut( pTask, pcNumber, ( size_t ) ( pcText - pcNumber ) );
+        addAccumulator( &total, negative ? -value : value );
+        operands++;
+
+        pcText = skipBlanks( pcText, pcLineEnd );
+        if ( pcText < pcLineEnd && *pcText == '+' ) {
+            pcText = skipBlanks( pcText + 1, pcLineEnd );
+        }
+        else {
+            break;
+        }
+    }
+
+    if ( valid && pcText < pcLineEnd && *pcText == '=' ) { /* stated total */
+        pcStated = skipBlanks( pcText + 1, pcLineEnd );
+        pcText = pcStated;
+        if ( pcText < pcLineEnd && *pcText == '-' ) {
+            pcText++;
+        }
+        while ( pcText < pcLineEnd && *pcText >= '0' && *pcText <= '9' ) {
+            pcText++;
+        }
+        statedLength = ( size_t ) ( pcText - pcStated );
+        pcText = skipBlanks( pcText, pcLineEnd );
+        valid = ( statedLength > 0 );
+    }
+
+    if ( !valid || pcText != pcLineEnd ) { /* not in the expected format, copy it through unchanged */
+        pTask->outLength = mark;
+        appendOut( pTask, pcLine, ( size_t ) ( pcLineEnd - pcLine ) );
+        appendOut( pTask, "\n", 1 );
+        freeAccumulator( &total );
+        return FALSE;
+    }
+
+    totalLength = accumulatorLength( &total );
+    if ( totalLength > sizeof( acTotal ) && ( pcTotal = ( char* ) malloc( totalLength ) ) == NULL ) {
+        pTask->failed = TRUE;
+        freeAccumulator( &total );
+        return TRUE; /* the run fails, there is nothing to flag */
+    }
+    formatAccumulator( &total, pcTotal );
+
+    if ( operands > 1 ) {
+        appendOut( pTask, " = ", 3 );
+        appendOut( pTask, pcTotal, totalLength );
+    }
+    appendOut( pTask, "\n", 1 );
+
+    if ( pcStated != NULL ) {
+        matched = ( statedLength == totalLength && memcmp( pcStated, pcTotal, totalLength ) == 0 );
+    }
+
+    if ( pcTotal != acTotal ) {
+        free( pcTotal );
+    }
+    freeAccumulator( &total );
+
+    return matched;
+}
+
+
+/**
+ * @brief  re-totals every line of one task's block, stopping early once the task has failed.
+ * @param  pTask: the task (Type: Pointer to a type defined struct called "EvalTask").
+ * @retval None
+ */
+static void evaluateTask( EvalTask* pTask ) {
+    const char* pcLine = pTask->pcStart;
+    const char* pcLineEnd;
+
+    while ( pcLine < pTask->pcEnd && !pTask->failed ) {
+        pcLineEnd = ( const char* ) memchr( pcLine, '\n', ( size_t ) ( pTask->pcEnd - pcLine ) );
+        if ( pcLineEnd == NULL ) {
+            pcLineEnd = pTask->pcEnd;
+        }
+
+        if ( !evaluateLine( pTask, pcLine, pcLineEnd ) ) {
+            flagLine( pTask, pTask->lineCount );
+        }
+
+        pTask->lineCount++;
+        pcLine = pcLineEnd + 1;
+    }
+}
+
+
+/**
+ * @brief  writes every byte of a buffer to a file descriptor.
+ * @retval returns TRUE if everything was written, FALSE on error.
+ */
+static int writeAll( int fd, const char* pcData, size_t length ) {
+    ssize_t written;
+
+    while ( length > 0 ) {
+        written = write( fd, pcData, length );
+        if ( written < 0 ) {
+            if ( errno != EINTR ) {
+                return FALSE;
+            }
+        }
+        else {
+            pcData += written;
+            length -= ( size_t ) written;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  worker thread of an EvalPool, re-totals its task's block each time a round starts until the pool is stopped.
+ * @param  pArg: the worker's task (Type: Pointer to a type defined struct called "EvalTask").
+ * @retval returns NULL.
+ */
+static void* runEvalWorker( void* pArg ) {
+    EvalTask* pTask = ( EvalTask* ) pArg;
+    EvalPool* pPool = pTask->pPool;
+    unsigned long round = 0; /* last round this worker ran */
+
+    pthread_mutex_lock( &pPool->lock );
+    for ( ;; ) {
+        while ( pPool->round == round && !pPool->stop ) {
+            pthread_cond_wait( &pPool->roundStarted, &pPool->lock );
+        }
+        if ( pPool->stop ) {
+            break;
+        }
+        round = pPool->round;
+        pthread_mutex_unlock( &pPool->lock );
+
+        evaluateTask( pTask );
+
+        pthread_mutex_lock( &pPool->lock );
+        if ( --pPool->pending == 0 ) {
+            pthread_cond_signal( &pPool->roundDone );
+        }
+    }
+    pthread_mutex_unlock( &pPool->lock );
+
+    return NULL;
+}
+
+
+/**
+ * @brief  starts a worker thread for every task but the first, which the calling thread runs itself.
+ * @note   the threads live until stopEvalPool, so a multi-GB input costs one pthread_create per thread, not one per round.
+ * @retval None
+ */
+static void startEvalPool( EvalPool* pPool, EvalTask* paTasks, int threadCount ) {
+    int task;
+
+    pPool->paTasks = paTasks;
+    pPool->threadCount = threadCount;
+    pPool->round = 0;
+    pPool->pending = 0;
+    pPool->stop = FALSE;
+    pthread_mutex_init( &pPool->lock, NULL );
+    pthread_cond_init( &pPool->roundStarted, NULL );
+    pthread_cond_init( &pPool->roundDone, NULL );
+
+    for ( task = 1 ; task < threadCount ; task++ ) {
+        paTasks[task].pPool = pPool;
+        pPool->aStarted[task] = ( pthread_create( &pPool->aThreads[task], NULL, &runEvalWorker, &paTasks[task] ) == 0 );
+    }
+}
+
+
+/**
+ * @brief  re-totals one round of blocks, one per thread, the calling thread taking the first.
+ * @note   returns once every block of the round is done; a task whose thread could not be started is run here.
+ * @retval None
+ */
+static void evaluateRound( EvalPool* pPool ) {
+    int task;
+
+    pthread_mutex_lock( &pPool->lock );
+    for ( task = 1 ; task < pPool->threadCount ; task++ ) {
+        pPool->pending += pPool->aStarted[task];
+    }
+    pPool->round++;
+    pthread_cond_broadcast( &pPool->roundStarted );
+    pthread_mutex_unlock( &pPool->lock );
+
+    evaluateTask( &pPool->paTasks[0] );
+    for ( task = 1 ; task < pPool->threadCount ; task++ ) {
+        if ( !pPool->aStarted[task] ) {
+            evaluateTask( &pPool->paTasks[task] ); /* thread could not be started, do its block here */
+        }
+    }
+
+    pthread_mutex_lock( &pPool->lock );
+    while ( pPool->pending > 0 ) {
+        pthread_cond_wait( &pPool->roundDone, &pPool->lock );
+    }
+    pthread_mutex_unlock( &pPool->lock );
+}
+
+
+/**
+ * @brief  stops and joins the pool's worker threads.
+ * @retval None
+ */
+static void stopEvalPool( EvalPool* pPool ) {
+    int task;
+
+    pthread_mutex_lock( &pPool->lock );
+    pPool->stop = TRUE;
+    pthread_cond_broadcast( &pPool->roundStarted );
+    pthread_mutex_unlock( &pPool->lock );
+
+    for ( task = 1 ; task < pPool->threadCount ; task++ ) {
+        if ( pPool->aStarted[task] ) {
+            pthread_join( pPool->aThreads[task], NULL );
+        }
+    }
+
+    pthread_cond_destroy( &pPool->roundDone );
+    pthread_cond_destroy( &pPool->roundStarted );
+    pthread_mutex_destroy( &pPool->lock );
+}
+
+
+/**
+ * @brief  re-totals a file of addition sequences written by writeDataToFile, using a pool of threads.
+ * @note   the input is memory-mapped and re-totaled in rounds: each round gives every thread the next block of at most 
+ * * EVAL_BLOCK_SIZE bytes (an equal share of the input if that is smaller), split at line boundaries, and the blocks' 
+ * * output is written in order before the next round reuses the buffers, and the input pages already re-totaled are 
+ * * unmapped. Memory use is therefore bounded by the thread count rather than the input size, so multi-GB inputs 
+ * * re-total in a few tens of MiB per thread. The threads are started once and wait between rounds. Lines whose stated 
+ * * total is wrong, or that could not be parsed, are reported on stderr with their line number. If an output buffer 
+ * * cannot be grown the run fails.
+ * @param  pcInPath: file to re-total (Type: Char array).
+ * @param  pcOutPath: file to write the re-totaled lines to (Type: Char array).
+ * @param  threadCount: threads to use, the amount of online processors if 0 or less (Type: Integer).
+ * @retval returns the amount of flagged lines, -1 if a file could not be read or written.
+ */
+long evaluateFile( const char* pcInPath, const char* pcOutPath, int threadCount ) {
+    EvalTask aTasks[EVAL_MAX_THREADS];
+    EvalPool pool;
+    struct stat info;
+    const char* pcInput = NULL;
+    const char* pcInputEnd;
+    const char* pcSplit;
+    const char* pcMapped; /* start of the part of the input still mapped */
+    size_t inputSize = 0, blockSize, pageSize = ( size_t ) sysconf( _SC_PAGESIZE ), done;
+    long flagged = 0, lineBase = 0, index;
+    int inFd, outFd, task, ok = TRUE;
+
+    if ( threadCount <= 0 ) {
+        threadCount = ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threadCount < 1 ) {
+        threadCount = 1;
+    }
+    if ( threadCount > EVAL_MAX_THREADS ) {
+        threadCount = EVAL_MAX_THREADS;
+    }
+
+    inFd = open( pcInPath, O_RDONLY );
+    if ( inFd < 0 || fstat( inFd, &info ) != 0 ) {
+        if ( inFd >= 0 ) {
+            close( inFd );
+        }
+        return -1;
+    }
+
+    inputSize = ( size_t ) info.st_size;
+    if ( inputSize > 0 ) {
+        pcInput = ( const char* ) mmap( NULL, inputSize, PROT_READ, MAP_PRIVATE, inFd, 0 );
+        if ( pcInput == MAP_FAILED ) {
+            close( inFd );
+            return -1;
+        }
+        posix_madvise( ( void* ) pcInput, inputSize, POSIX_MADV_SEQUENTIAL );
+    }
+    close( inFd );
+
+    outFd = open( pcOutPath, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    ok = ( outFd >= 0 );
+
+    for ( task = 0 ; task < threadCount ; task++ ) {
+        memset( &aTasks[task], 0, sizeof( EvalTask ) );
+    }
+
+    /* small inputs are shared out evenly, large ones go in rounds of EVAL_BLOCK_SIZE blocks */
+    blockSize = ( inputSize + ( size_t ) threadCount - 1 ) / ( size_t ) threadCount;
+    if ( blockSize > EVAL_BLOCK_SIZE ) {
+        blockSize = EVAL_BLOCK_SIZE;
+    }
+
+    pcInputEnd = pcInput + inputSize;
+    pcSplit = pcInput;
+    pcMapped = pcInput;
+
+    startEvalPool( &pool, aTasks, threadCount );
+
+    while ( ok && pcSplit < pcInputEnd ) {
+        /* the next block for every thread, each ending just after a '\n' */
+        for ( task = 0 ; task < threadCount ; task++ ) {
+            aTasks[task].pcStart = pcSplit;
+
+            if ( ( size_t ) ( pcInputEnd - pcSplit ) > blockSize ) {
+                pcSplit = ( const char* ) memchr( pcSplit + blockSize, '\n', ( size_t ) ( pcInputEnd - pcSplit ) - blockSize );
+                pcSplit = ( pcSplit == NULL ) ? pcInputEnd : pcSplit + 1;
+            }
+            else {
+                pcSplit = pcInputEnd;
+            }
+
+            aTasks[task].pcEnd = pcSplit;
+            aTasks[task].outLength = 0;
+            aTasks[task].lineCount = 0;
+            aTasks[task].flaggedCount = 0;
+        }
+
+        evaluateRound( &pool );
+
+        for ( task = 0 ; task < threadCount ; task++ ) {
+            if ( ok ) {
+                ok = !aTasks[task].failed && writeAll( outFd, aTasks[task].pcOut, aTasks[task].outLength );
+            }
+
+            for ( index = 0 ; index < aTasks[task].flaggedCount ; index++ ) {
+                fprintf( stderr, "%s:%ld: total does not match or line is malformed\n", pcInPath, lineBase + aTasks[task].plFlagged[index] + 1 );
+            }
+            flagged += aTasks[task].flaggedCount;
+            lineBase += aTasks[task].lineCount;
+        }
+
+        /* unmap the whole pages re-totaled so far, so the input's page cache does not pile up in this process either */
+        done = ( size_t ) ( pcSplit - pcInput ) / pageSize * pageSize;
+        if ( pcInput + done > pcMapped ) {
+            munmap( ( void* ) pcMapped, ( size_t ) ( pcInput + done - pcMapped ) );
+            pcMapped = pcInput + done;
+        }
+    }
+
+    stopEvalPool( &pool );
+
+    for ( task = 0 ; task < threadCount ; task++ ) {
+        free( aTasks[task].pcOut );
+        free( aTasks[task].plFlagged );
+    }
+
+    if ( outFd >= 0 && close( outFd ) != 0 ) {
+        ok = FALSE;
+    }
+    if ( pcMapped < pcInputEnd ) {
+        munmap( ( void* ) pcMapped, ( size_t ) ( pcInputEnd - pcMapped ) );
+    }
+
+    return ok ? flagged : -1;
+}
@@ -0,0 +1,42 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define EVAL_MAX_THREADS 256
+#define EVAL_BLOCK_SIZE ( 8UL << 20 ) /* most input bytes a thread re-totals per round, which bounds its output buffer */
+
+typedef struct EvalTask
+{
+	const char* pcStart; /* first byte of this round's lines */
+	const char* pcEnd; /* one past the last byte, always just after a '\n' or the end of the input */
+	char* pcOut; /* re-totaled lines of this round, reused from round to round */
+	size_t outLength;
+	size_t outCapacity;
+	long lineCount; /* lines in this round */
+	long* plFlagged; /* round-relative line numbers whose total did not match or could not be parsed */
+	long flaggedCount;
+	long flaggedCapacity;
+	int failed; /* TRUE once an output or flag buffer could not be grown, the rest of the round is skipped */
+	struct EvalPool* pPool; /* pool whose worker runs this task */
+} EvalTask;
+
+typedef struct EvalPool
+{
+	EvalTask* paTasks; /* one task per thread, task 0 run by the calling thread */
+	int threadCount;
+	pthread_t aThreads[EVAL_MAX_THREADS];
+	int aStarted[EVAL_MAX_THREADS]; /* TRUE if the task's worker thread is running */
+	pthread_mutex_t lock; /* guards round, pending and stop */
+	pthread_cond_t roundStarted; /* broadcast when round or stop change */
+	pthread_cond_t roundDone; /* signalled when pending drops to 0 */
+	unsigned long round; /* rounds started so far */
+	int pending; /* worker threads still busy with the current round */
+	int stop; /* TRUE once the workers are to exit */
+} EvalPool;
+
+
+long evaluateFile( const char* pcInPath, const char* pcOutPath, int threadCount );
+
+#endif
@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "intList.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+
+/**
+ * @brief  creates the unrolled integer list.
+ * @note   integers are stored by value in chunks of INT_LIST_CHUNK_CAPACITY, so each value costs 4 bytes plus a share of 
+ * * one chunk header instead of a node and a separate allocation.
+ * @retval Returns Int List Struct.
+ */
+IntList* createIntList() {
+    IntList* pList = ( IntList* ) malloc( sizeof( IntList ) );
+    pList->head = NULL;
+    pList->tail = NULL;
+    pList->pSpare = NULL;
+    pList->size = 0;
+    pList->maxResident = 0;
+    pList->spillFd = -1;
+    pList->spilledChunks = 0;
+    pList->pSpillBuffer = NULL;
+
+    return pList;
+}
+
+
+/**
+ * @brief  creates the spill file in $TMPDIR (or /tmp) and unlinks it straight away, so it is freed however the program ends.
+ * @retval returns the file descriptor, -1 on error.
+ */
+static int openSpillFile() {
+    const char* pcDir = getenv( "TMPDIR" );
+    char* pcPath;
+    int fd;
+
+    if ( pcDir == NULL || pcDir[0] == '\0' ) {
+        pcDir = "/tmp";
+    }
+
+    pcPath = ( char* ) malloc( strlen( pcDir ) + strlen( "/calculator-spill-XXXXXX" ) + 1 );
+    if ( pcPath == NULL ) {
+        return -1;
+    }
+    sprintf( pcPath, "%s/calculator-spill-XXXXXX", pcDir );
+
+    if ( ( fd = mkstemp( pcPath ) ) >= 0 ) {
+        unlink( pcPath );
+    }
+
+    free( pcPath );
+    return fd;
+}
+
+
+/**
+ * @brief  moves the oldest INT_LIST_SPILL_BATCH chunks to the spill file once the list holds a batch more than its limit.
+ * @note   only full chunks older than the tail are spilled, so a spilled chunk is always INT_LIST_CHUNK_CAPACITY values. 
+ * * The batch goes out as one sequential writev at the end of the spilled data. If the write fails the chunks simply 
+ * * stay in memory and the next new chunk tries again.
+ * @retval None
+ */
+static void spillOldest( IntList* pList ) {
+    struct iovec aBlocks[INT_LIST_SPILL_BATCH];
+    IntListChunk* pChunk;
+    long resident = pList->size - pList->spilledChunks * INT_LIST_CHUNK_CAPACITY;
+    size_t length = INT_LIST_SPILL_CHUNK_BYTES * INT_LIST_SPILL_BATCH;
+    int index;
+
+    if ( pList->maxResident == 0 || resident <= pList->maxResident + ( long ) INT_LIST_SPILL_BATCH * INT_LIST_CHUNK_CAPACITY ) {
+        return;
+    }
+
+    if ( pList->spillFd < 0 && ( pList->spillFd = openSpillFile() ) < 0 ) {
+        return;
+    }
+
+    for ( index = 0, pChunk = pList->head ; index < INT_LIST_SPILL_BATCH ; index++, pChunk = pChunk->next ) {
+        aBlocks[index].iov_base = pChunk->values;
+        aBlocks[index].iov_len = INT_LIST_SPILL_CHUNK_BYTES;
+    }
+
+    if ( lseek( pList->spillFd, ( off_t ) pList->spilledChunks * ( off_t ) INT_LIST_SPILL_CHUNK_BYTES, SEEK_SET ) < 0 
+         || writev( pList->spillFd, aBlocks, INT_LIST_SPILL_BATCH ) != ( ssize_t ) length ) {
+        return;
+    }
+
+    for ( index = 0 ; index < INT_LIST_SPILL_BATCH ; index++ ) {
+        pChunk = pList->head;
+        pList->head = pChunk->next;
+        pList->head->prev = NULL;
+
+        if ( pList->pSpare == NULL ) {
+            pList->pSpare = pChunk;
+        }
+        else {
+            free( pChunk );
+        }
+    }
+
+    pList->spilledChunks += INT_LIST_SPILL_BATCH;
+}
+
+
+/**
+ * @brief  bounds how many values the list keeps in memory; older values are spilled to a temporary file.
+ * @note   the list keeps the newest maxResident values (rounded up to whole chunks) plus at most one spill batch in 
+ * * memory, so its memory use stays flat however long it grows. Spilled values are still part of the list: the iterators 
+ * * read them back in order and removeLastInt reloads the newest spilled chunk once memory runs out of values.
+ * @param  pList: list to bound (Type: Pointer to a type defined struct called "IntList").
+ * @param  maxResident: values to keep in memory, 0 for no limit (Type: Long).
+ * @retval returns TRUE on success, FALSE if the read-back buffer could not be allocated.
+ */
+int setIntListResidentLimit( IntList* pList, long maxResident ) {
+    if ( maxResident > 0 && pList->pSpillBuffer == NULL ) {
+        if ( ( pList->pSpillBuffer = ( IntListChunk* ) malloc( sizeof( IntListChunk ) ) ) == NULL ) {
+            return FALSE;
+        }
+        pList->pSpillBuffer->next = NULL;
+        pList->pSpillBuffer->prev = NULL;
+        pList->pSpillBuffer->count = 0;
+    }
+
+    pList->maxResident = maxResident;
+    return TRUE;
+}
+
+
+/**
+ * @brief  reads one spilled chunk back from the spill file.
+ * @param  pList: list the chunk was spilled from (Type: Pointer to a type defined struct called "IntList").
+ * @param  index: chunk to read, 0 for the oldest, below pList->spilledChunks (Type: Long).
+ * @param  piValues: receives the INT_LIST_CHUNK_CAPACITY values of the chunk (Type: Pointer to Integer).
+ * @retval returns TRUE if the whole chunk was read.
+ */
+int readSpilledChunk( const IntList* pList, long index, int* piValues ) {
+    off_t offset = ( off_t ) index * ( off_t ) INT_LIST_SPILL_CHUNK_BYTES;
+    size_t count = 0;
+    ssize_t bytesRead;
+
+    while ( count < INT_LIST_SPILL_CHUNK_BYTES ) {
+        bytesRead = pread( pList->spillFd, ( char* ) piValues + count, INT_LIST_SPILL_CHUNK_BYTES - count, offset + ( off_t ) count );
+
+        if ( bytesRead < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( bytesRead <= 0 ) {
+            return FALSE;
+        }
+        count += ( size_t ) bytesRead;
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  inserts an integer last in the list.
+ * @note   a new chunk is only needed once every INT_LIST_CHUNK_CAPACITY values.
+ * @param  pList: list to insert into (Type: Pointer to a type defined struct called "IntList").
+ * @param  value: value to insert (Type: Integer).
+ * @retval returns TRUE if inserted, FALSE if a chunk could not be allocated.
+ */
+int insertLastInt( IntList* pList, int value ) {
+    IntListChunk* pChunk = pList->tail;
+
+    if ( pChunk == NULL || pChunk->count == INT_LIST_CHUNK_CAPACITY ) { /* tail chunk is full, link a new one */
+
+        if ( pList->pSpare != NULL ) {
+            pChunk = pList->pSpare;
+            pList->pSpare = NULL;
+        }
+        else {
+            pChunk = ( IntListChunk* ) malloc( sizeof( IntListChunk ) );
+
+            if ( pChunk == NULL ) {
+                return FALSE;
+            }
+        }
+
+        pChunk->count = 0;
+        pChunk->next = NULL;
+        pChunk->prev = pList->tail;
+
+        if ( pList->tail == NULL ) { /* list was empty */
+            pList->head = pChunk;
+        }
+        else {
+            pList->tail->next = pChunk;
+        }
+
+        pList->tail = pChunk;
+    }
+
+    pChunk->values[pChunk->count++] = value;
+    ( pList->size )++;
+
+    if ( pChunk->count == 1 ) {
+        spillOldest( pList ); /* the list has grown by a chunk */
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  appends a block of integers, filling the tail chunk and then whole new chunks with memcpy.
+ * @note   the same as insertLastInt for each value in turn, including spilling, at a fraction of the cost per value.
+ * @param  pList: list to append to (Type: Pointer to a type defined struct called "IntList").
+ * @param  piValues: values to append, oldest first (Type: Pointer to Integer).
+ * @param  count: amount of values (Type: Long).
+ * @retval returns TRUE if all were appended, FALSE if a chunk could not be allocated (the values before it were appended).
+ */
+int appendInts( IntList* pList, const int* piValues, long count ) {
+    IntListChunk* pChunk;
+    long copied;
+
+    while ( count > 0 ) {
+        pChunk = pList->tail;
+
+        if ( pChunk == NULL || pChunk->count == INT_LIST_CHUNK_CAPACITY ) { /* start the next chunk with one value */
+            if ( !insertLastInt( pList, *piValues ) ) {
+                return FALSE;
+            }
+            piValues++;
+            count--;
+            continue;
+        }
+
+        copied = INT_LIST_CHUNK_CAPACITY - pChunk->count;
+        if ( copied > count ) {
+            copied = count;
+        }
+
+        memcpy( pChunk->values + pChunk->count, piValues, sizeof( int ) * ( size_t ) copied );
+        pChunk->count += ( int ) copied;
+        pList->size += copied;
+        piValues += copied;
+        count -= copied;
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  removes the last integer in the list in constant time.
+ * @note   an emptied chunk is kept as a spare, the previous spare (if any) is freed. Once every value in memory has been 
+ * * removed the newest spilled chunk is read back in.
+ * @param  pList: list to remove from (Type: Pointer to a type defined struct called "IntList").
+ * @param  piValue: receives the removed value, may be NULL (Type: Pointer to Integer).
+ * @retval returns TRUE if a value was removed, FALSE if the list was empty or a spilled chunk could not be read back.
+ */
+int removeLastInt( IntList* pList, int* piValue ) {
+    IntListChunk* pChunk = pList->tail;
+
+    if ( pChunk == NULL ) {
+        if ( pList->spilledChunks == 0 ) {
+            return FALSE;
+        }
+
+        /* reload the newest spilled chunk; its place in the spill file is reused by the next spill */
+        pChunk = ( pList->pSpare != NULL ) ? pList->pSpare : ( IntListChunk* ) malloc( sizeof( IntListChunk ) );
+        if ( pChunk == NULL || !readSpilledChunk( pList, pList->spilledChunks - 1, pChunk->values ) ) {
+            if ( pChunk != pList->pSpare ) {
+                free( pChunk );
+            }
+            return FALSE;
+        }
+
+        pList->pSpare = ( pChunk == pList->pSpare ) ? NULL : pList->pSpare;
+        pChunk->count = INT_LIST_CHUNK_CAPACITY;
+        pChunk->next = NULL;
+        pChunk->prev = NULL;
+        pList->head = pChunk;
+        pList->tail = pChunk;
+        pList->spilledChunks--;
+    }
+
+    pChunk->count--;
+    if ( piValue != NULL ) {
+        *piValue = pChunk->values[pChunk->count];
+    }
+    ( pList->size )--;
+
+    if ( pChunk->count == 0 ) { /* unlink the emptied chunk */
+        pList->tail = pChunk->prev;
+
+        if ( pList->tail == NULL ) {
+            pList->head = NULL;
+        }
+        else {
+            pList->tail->next = NULL;
+        }
+
+        free( pList->pSpare );
+        pList->pSpare = pChunk;
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  frees the list and all of its chunks.
+ * @param  pList: list to free (Type: Pointer to a type defined struct called "IntList").
+ * @retval None
+ */
+void freeIntList( IntList* pList ) {
+    IntListChunk* pChunk = pList->head;
+    IntListChunk* pTemp;
+
+    while ( pChunk ) {
+        pTemp = pChunk->next;
+        free( pChunk );
+        pChunk = pTemp;
+    }
+
+    if ( pList->spillFd >= 0 ) {
+        close( pList->spillFd );
+    }
+
+    free( pList->pSpillBuffer );
+    free( pList->pSpare );
+    free( pList );
+}
+
+
+/**
+ * @brief  starts iterating the list from the first inserted value.
+ * @note   spilled values are read back one chunk at a time into the list's pSpillBuffer, so only one iterator may walk a 
+ * * list with spilled chunks at once.
+ * @param  pList: list to iterate (Type: Pointer to a type defined struct called "IntList").
+ * @param  pIter: iterator to initialise (Type: Pointer to a type defined struct called "IntListIterator").
+ * @retval None
+ */
+void startIntListIterator( const IntList* pList, IntListIterator* pIter ) {
+    pIter->pList = pList;
+    pIter->index = 0;
+    pIter->spilledIndex = 0;
+    pIter->failed = FALSE;
+
+    if ( pList->spilledChunks > 0 ) {
+        pIter->pChunk = pList->pSpillBuffer;
+        pIter->pChunk->count = 0; /* nothing read back yet */
+    }
+    else {
+        pIter->pChunk = pList->head;
+    }
+}
+
+
+/**
+ * @brief  returns the next value walking from the first to the last inserted value.
+ * @param  pIter: iterator started with startIntListIterator (Type: Pointer to a type defined struct called "IntListIterator").
+ * @param  piValue: receives the value (Type: Pointer to Integer).
+ * @retval returns TRUE if a value was returned, FALSE at the end of the list or if pIter->failed was set.
+ */
+int nextInt( IntListIterator* pIter, int* piValue ) {
+    const IntList* pList = pIter->pList;
+
+    while ( pIter->pChunk != NULL && pIter->index == pIter->pChunk->count ) { /* move on to the next chunk */
+        if ( pIter->pChunk != pList->pSpillBuffer ) {
+            pIter->pChunk = pIter->pChunk->next;
+        }
+        else if ( pIter->spilledIndex < pList->spilledChunks ) {
+            if ( !readSpilledChunk( pList, pIter->spilledIndex++, pIter->pChunk->values ) ) {
+                pIter->failed = TRUE;
+                pIter->pChunk = NULL;
+                return FALSE;
+            }
+            pIter->pChunk->count = INT_LIST_CHUNK_CAPACITY;
+        }
+        else {
+            pIter->pChunk = pList->head; /* spilled chunks done, carry on with the ones in memory */
+        }
+        pIter->index = 0;
+    }
+
+    if ( pIter->pChunk == NULL ) {
+        return FALSE;
+    }
+
+    *piValue = pIter->pChunk->values[pIter->index++];
+    return TRUE;
+}
+
+
+/**
+ * @brief  starts iterating the list from the last inserted value.
+ * @note   spilled values are read back as for startIntListIterator.
+ * @param  pList: list to iterate (Type: Pointer to a type defined struct called "IntList").
+ * @param  pIter: iterator to initialise (Type: Pointer to a type defined struct called "IntListIterator").
+ * @retval None
+ */
+void startIntListReverseIterator( const IntList* pList, IntListIterator* pIter ) {
+    pIter->pList = pList;
+    pIter->pChunk = ( pList->tail != NULL || pList->spilledChunks == 0 ) ? pList->tail : pList->pSpillBuffer;
+    pIter->index = ( pList->tail != NULL ) ? pList->tail->count : 0;
+    pIter->spilledIndex = pList->spilledChunks;
+    pIter->failed = FALSE;
+}
+
+
+/**
+ * @brief  returns the next value walking from the last to the first inserted value.
+ * @param  pIter: iterator started with startIntListReverseIterator (Type: Pointer to a type defined struct called "IntListIterator").
+ * @param  piValue: receives the value (Type: Pointer to Integer).
+ * @retval returns TRUE if a value was returned, FALSE once the first value has been passed or if pIter->failed was set.
+ */
+int nextIntReverse( IntListIterator* pIter, int* piValue ) {
+    const IntList* pList = pIter->pList;
+
+    while ( pIter->pChunk != NULL && pIter->index == 0 ) { /* move back to the previous chunk */
+        if ( pIter->pChunk != pList->pSpillBuffer && pIter->pChunk->prev != NULL ) {
+            pIter->pChunk = pIter->pChunk->prev;
+        }
+        else if ( pIter->spilledIndex > 0 ) { /* older than head, read back the spilled chunks newest first */
+            pIter->pChunk = pList->pSpillBuffer;
+            if ( !readSpilledChunk( pList, --pIter->spilledIndex, pIter->pChunk->values ) ) {
+                pIter->failed = TRUE;
+                pIter->pChunk = NULL;
+                return FALSE;
+            }
+            pIter->pChunk->count = INT_LIST_CHUNK_CAPACITY;
+        }
+        else {
+            pIter->pChunk = NULL;
+        }
+        pIter->index = ( pIter->pChunk != NULL ) ? pIter->pChunk->count : 0;
+    }
+
+    if ( pIter->pChunk == NULL ) {
+        return FALSE;
+    }
+
+    *piValue = pIter->pChunk->values[--pIter->index];
+    return TRUE;
+}
@@ -0,0 +1,50 @@
+#ifndef INTLIST_H
+#define INTLIST_H
+
+#define INT_LIST_CHUNK_CAPACITY 1020 /* keeps a chunk, header included, at about 4 KiB */
+#define INT_LIST_SPILL_BATCH 16 /* chunks written to the spill file with one writev, about 64 KiB */
+#define INT_LIST_SPILL_CHUNK_BYTES ( sizeof( int ) * INT_LIST_CHUNK_CAPACITY ) /* a spilled chunk is only its values */
+
+typedef struct IntListChunk
+{
+	struct IntListChunk* next;
+	struct IntListChunk* prev;
+	int count; /* values in use */
+	int values[INT_LIST_CHUNK_CAPACITY]; /* values stored contiguously, oldest first */
+} IntListChunk;
+
+typedef struct IntList
+{
+	IntListChunk* head; /* oldest chunk in memory */
+	IntListChunk* tail;
+	IntListChunk* pSpare; /* emptied chunk kept so appends and pops across a chunk boundary do not malloc/free each time */
+	long size; /* values in the list, spilled ones included */
+	long maxResident; /* values kept in memory before the oldest chunks are spilled, 0 for no limit */
+	int spillFd; /* unlinked temporary file of spilled chunks, -1 until the first spill */
+	long spilledChunks; /* full chunks in the spill file, oldest first, all older than head */
+	IntListChunk* pSpillBuffer; /* chunk the iterators read spilled values back into, NULL without a limit */
+} IntList;
+
+typedef struct IntListIterator
+{
+	const IntList* pList;
+	IntListChunk* pChunk; /* chunk being walked, pList->pSpillBuffer while walking spilled chunks */
+	int index;
+	long spilledIndex; /* next spilled chunk to read forwards, spilled chunks left to read in reverse */
+	int failed; /* TRUE if a spilled chunk could not be read back, ending the walk early */
+} IntListIterator;
+
+
+IntList* createIntList();
+int insertLastInt( IntList* pList, int value );
+int appendInts( IntList* pList, const int* piValues, long count );
+int removeLastInt( IntList* pList, int* piValue );
+void freeIntList( IntList* pList );
+int setIntListResidentLimit( IntList* pList, long maxResident );
+int readSpilledChunk( const IntList* pList, long index, int* piValues );
+void startIntListIterator( const IntList* pList, IntListIterator* pIter );
+int nextInt( IntListIterator* pIter, int* piValue );
+void startIntListReverseIterator( const IntList* pList, IntListIterator* pIter );
+int nextIntReverse( IntListIterator* pIter, int* piValue );
+
+#endif
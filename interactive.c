@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include "interactive.h"
+
+
+/**
+ * @brief  copies what the renderer draws from one session into another, leaving out the operand list, journal and monitor.
+ * @retval None
+ */
+static void copyDisplay( Session* pDest, const Session* pSrc ) {
+    pDest->keyboard = pSrc->keyboard;
+    pDest->cursorKey = pSrc->cursorKey;
+    pDest->currNum = pSrc->currNum;
+    pDest->digitCount = pSrc->digitCount;
+    copyAccumulator( &pDest->total, &pSrc->total );
+    pDest->pList = NULL;
+    pDest->pJournal = NULL;
+    pDest->pMonitor = NULL;
+}
+
+
+/**
+ * @brief  hands the state after a batch to the render thread, replacing any snapshot it has not drawn yet.
+ * @retval None
+ */
+static void publishSnapshot( Interactive* pContext, const Session* pSession ) {
+    pthread_mutex_lock( &pContext->lock );
+    copyDisplay( &pContext->snapshot, pSession );
+    pContext->version++;
+    pthread_cond_signal( &pContext->changed );
+    pthread_mutex_unlock( &pContext->lock );
+}
+
+
+/**
+ * @brief  draws a session, timed into pStats when it is not NULL.
+ * @retval None
+ */
+static void timedRender( Renderer* pRenderer, const Session* pSession, Stats* pStats ) {
+    unsigned long startNs = 0;
+
+    if ( pStats != NULL ) {
+        startNs = statsNow( pStats );
+    }
+
+    renderCalculator( pRenderer, pSession );
+
+    if ( pStats != NULL ) {
+        recordPhase( pStats, STATS_PHASE_RENDER, startNs, statsNow( pStats ) );
+    }
+}
+
+
+/**
+ * @brief  input thread: reads stdin into the key queue until the input closes or the stop pipe is written.
+ * @note   a full queue is retried every INTERACTIVE_FULL_WAIT_MS rather than dropping keys, so the terminal's own buffer
+ * * holds anything typed beyond KEY_QUEUE_SIZE. The stop pipe is watched while waiting too: once the state thread has
+ * * stopped nobody pops the queue again, so the keys still in hand are dropped. The queue is closed on the way out.
+ * @retval returns NULL.
+ */
+static void* inputThread( void* pArg ) {
+    Interactive* pContext = ( Interactive* ) pArg;
+    char acInput[INPUT_BATCH_SIZE];
+    struct pollfd aWaiting[2];
+    size_t inputCount, pushed;
+    int stopped = FALSE;
+    unsigned long startNs = 0;
+
+    aWaiting[0].fd = STDIN_FILENO;
+    aWaiting[0].events = POLLIN;
+    aWaiting[1].fd = pContext->aiStopPipe[0];
+    aWaiting[1].events = POLLIN;
+
+    while ( !stopped ) {
+        if ( poll( aWaiting, 2, -1 ) < 0 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+        if ( aWaiting[1].revents != 0 ) {
+            break; /* the state thread has finished */
+        }
+
+        if ( pContext->pInputStats != NULL ) {
+            startNs = statsNow( pContext->pInputStats );
+        }
+
+        /* stdin is readable (or closed), so this does not block */
+        if ( ( inputCount = readKeystrokes( STDIN_FILENO, acInput, INPUT_BATCH_SIZE ) ) == 0 ) {
+            break;
+        }
+
+        /* wait on the stop pipe alone while the queue is full */
+        for ( pushed = 0 ; !stopped && ( pushed += pushKeys( &pContext->keys, acInput + pushed, inputCount - pushed ) ) < inputCount ; ) {
+            stopped = ( poll( &aWaiting[1], 1, INTERACTIVE_FULL_WAIT_MS ) > 0 );
+        }
+
+        if ( pContext->pInputStats != NULL ) {
+            recordPhase( pContext->pInputStats, STATS_PHASE_INPUT, startNs, statsNow( pContext->pInputStats ) );
+        }
+    }
+
+    closeKeyQueue( &pContext->keys );
+    return NULL;
+}
+
+
+/**
+ * @brief  render thread: draws the newest published snapshot until the state thread is done.
+ * @note   snapshots published while a frame is being drawn replace each other, so under load only the latest state is
+ * * drawn and the intermediate frames are skipped. The snapshot is copied out under the lock and drawn outside it.
+ * @retval returns NULL.
+ */
+static void* renderThread( void* pArg ) {
+    Interactive* pContext = ( Interactive* ) pArg;
+    unsigned long drawn = 0;
+    Session view;
+
+    initAccumulator( &view.total );
+
+    for ( ;; ) {
+        pthread_mutex_lock( &pContext->lock );
+        while ( pContext->version == drawn && !pContext->done ) {
+            pthread_cond_wait( &pContext->changed, &pContext->lock );
+        }
+        if ( pContext->version == drawn ) { /* done, and the last snapshot is already on screen */
+            pthread_mutex_unlock( &pContext->lock );
+            break;
+        }
+        copyDisplay( &view, &pContext->snapshot );
+        drawn = pContext->version;
+        pthread_mutex_unlock( &pContext->lock );
+
+        timedRender( pContext->pRenderer, &view, pContext->pRenderStats );
+    }
+
+    freeAccumulator( &view.total );
+    return NULL;
+}
+
+
+/**
+ * @brief  single threaded fallback: renders, reads a batch and applies it in turn until the session ends.
+ * @retval returns TRUE if the session confirmed "=", FALSE if the input closed.
+ */
+static int runSerial( Session* pSession, Renderer* pRenderer, Stats* pStats ) {
+    char acInput[INPUT_BATCH_SIZE];
+    size_t inputCount;
+    unsigned long startNs = 0;
+
+    for ( ;; ) {
+        timedRender( pRenderer, pSession, pStats );
+
+        if ( pStats != NULL ) {
+            startNs = statsNow( pStats );
+        }
+
+        waitForKeystrokes( STDIN_FILENO, pSession->pJournal );
+
+        if ( ( inputCount = readKeystrokes( STDIN_FILENO, acInput, INPUT_BATCH_SIZE ) ) == 0 ) {
+            return FALSE;
+        }
+
+        if ( pStats != NULL ) {
+            recordPhase( pStats, STATS_PHASE_INPUT, startNs, statsNow( pStats ) );
+        }
+
+        if ( applyKeystrokes( pSession, acInput, inputCount, pStats ) ) {
+            return TRUE;
+        }
+    }
+}
+
+
+/**
+ * @brief  runs an interactive session on stdin with reading, state updates and drawing each on their own thread.
+ * @note   an input thread reads stdin into a lock-free single-producer, single-consumer KeyQueue; the calling thread pops
+ * * whatever is queued, applies it to the session and publishes a display snapshot; a render thread draws only the
+ * * newest snapshot, so a burst of keys costs one frame rather than one per batch and slow terminal writes never hold up
+ * * the keys behind them. Falls back to doing all three in turn on the calling thread if the threads cannot be started.
+ * @param  pSession: session to apply the keystrokes to, owned by the calling thread throughout (Type: Pointer to a type defined struct called "Session").
+ * @param  pRenderer: renderer for stdout, used only by the render thread until this returns (Type: Pointer to a type defined struct called "Renderer").
+ * @param  pStats: statistics INPUT, DISPATCH and RENDER are timed into, or NULL (Type: Pointer to a type defined struct called "Stats").
+ * @retval returns TRUE if the session confirmed "=", FALSE if the input closed first.
+ */
+int runInteractive( Session* pSession, Renderer* pRenderer, Stats* pStats ) {
+    Interactive* pContext;
+    pthread_t inputId, renderId;
+    char acKeys[INPUT_BATCH_SIZE];
+    size_t count;
+    int confirmed = FALSE, closed;
+    int renderStarted;
+    char stop = 0;
+
+    /* the queue is too large for the stack */
+    if ( ( pContext = ( Interactive* ) malloc( sizeof( Interactive ) ) ) == NULL ) {
+        return runSerial( pSession, pRenderer, pStats );
+    }
+    if ( !initKeyQueue( &pContext->keys ) ) {
+        free( pContext );
+        return runSerial( pSession, pRenderer, pStats );
+    }
+    if ( pipe( pContext->aiStopPipe ) != 0 ) {
+        destroyKeyQueue( &pContext->keys );
+        free( pContext );
+        return runSerial( pSession, pRenderer, pStats );
+    }
+
+    pthread_mutex_init( &pContext->lock, NULL );
+    pthread_cond_init( &pContext->changed, NULL );
+    initAccumulator( &pContext->snapshot.total );
+    pContext->version = 0;
+    pContext->done = FALSE;
+    pContext->pRenderer = pRenderer;
+    pContext->pInputStats = ( pStats != NULL ) ? createStats( pStats->pEvents != NULL ) : NULL;
+    pContext->pRenderStats = ( pStats != NULL ) ? createStats( pStats->pEvents != NULL ) : NULL;
+
+    if ( pthread_create( &inputId, NULL, &inputThread, pContext ) != 0 ) {
+        confirmed = runSerial( pSession, pRenderer, pStats );
+    }
+    else {
+        publishSnapshot( pContext, pSession );
+
+        /* without a render thread, the state thread draws each batch itself */
+        if ( !( renderStarted = ( pthread_create( &renderId, NULL, &renderThread, pContext ) == 0 ) ) ) {
+            timedRender( pRenderer, pSession, pStats );
+        }
+
+        for ( ;; ) {
+            closed = keyQueueClosed( &pContext->keys ); /* read before popping, so an empty pop after it is final */
+
+            if ( ( count = popKeys( &pContext->keys, acKeys, INPUT_BATCH_SIZE ) ) > 0 ) {
+                if ( ( confirmed = applyKeystrokes( pSession, acKeys, count, pStats ) ) ) {
+                    break;
+                }
+
+                if ( renderStarted ) {
+                    publishSnapshot( pContext, pSession );
+                }
+                else {
+                    timedRender( pRenderer, pSession, pStats );
+                }
+            }
+            else if ( closed ) {
+                break; /* input closed, end the session as if "=" was pressed */
+            }
+            else {
+                /* idle: wake up in time to sync the journal records of the last batch */
+                waitKeys( &pContext->keys, journalSyncWaitMs( pSession->pJournal ) );
+                syncDueJournal( pSession->pJournal );
+            }
+        }
+
+        /* stop reading, then let the render thread finish its last frame */
+        while ( write( pContext->aiStopPipe[1], &stop, 1 ) < 0 && errno == EINTR ) {
+        }
+        pthread_join( inputId, NULL );
+
+        if ( renderStarted ) {
+            pthread_mutex_lock( &pContext->lock );
+            pContext->done = TRUE;
+            pthread_cond_signal( &pContext->changed );
+            pthread_mutex_unlock( &pContext->lock );
+            pthread_join( renderId, NULL );
+        }
+    }
+
+    if ( pStats != NULL ) {
+        mergeStats( pStats, pContext->pInputStats );
+        mergeStats( pStats, pContext->pRenderStats );
+        freeStats( pContext->pInputStats );
+        freeStats( pContext->pRenderStats );
+    }
+
+    freeAccumulator( &pContext->snapshot.total );
+    pthread_cond_destroy( &pContext->changed );
+    pthread_mutex_destroy( &pContext->lock );
+    close( pContext->aiStopPipe[0] );
+    close( pContext->aiStopPipe[1] );
+    destroyKeyQueue( &pContext->keys );
+    free( pContext );
+
+    return confirmed;
+}
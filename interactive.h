@@ -0,0 +1,28 @@
+#ifndef INTERACTIVE_H
+#define INTERACTIVE_H
+
+#include <pthread.h>
+#include "module.h"
+#include "render.h"
+#include "keyQueue.h"
+
+#define INTERACTIVE_FULL_WAIT_MS 1 /* input thread's back-off while the key queue is full */
+
+typedef struct Interactive
+{
+	KeyQueue keys; /* bytes read from stdin, input thread to state thread */
+	int aiStopPipe[2]; /* written by the state thread to stop the input thread */
+	pthread_mutex_t lock; /* guards snapshot, version and done */
+	pthread_cond_t changed; /* signalled when version or done change */
+	Session snapshot; /* display state of the newest batch, without the operand list, journal or monitor */
+	unsigned long version; /* batches published into snapshot */
+	int done; /* TRUE once the state thread has stopped publishing */
+	Renderer* pRenderer; /* drawn to only by the render thread */
+	Stats* pInputStats; /* INPUT timings of the input thread, NULL for none */
+	Stats* pRenderStats; /* RENDER timings of the render thread, NULL for none */
+} Interactive;
+
+
+int runInteractive( Session* pSession, Renderer* pRenderer, Stats* pStats );
+
+#endif
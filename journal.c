@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "journal.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+
+/**
+ * @brief  rebuilds the operand list and total from a journal left by an earlier session.
+ * @note   the journal is mapped read-only and replayed record by record. A torn record at the end (from a crash mid-write) 
+ * * is ignored. Replay stops at a record of unknown type or one that pops from an empty history, and that record is 
+ * * reported on stderr with how many records were left unreplayed. A missing or empty journal recovers nothing.
+ * @param  pcPath: journal file path (Type: Char array).
+ * @param  pList: list the recovered operands are appended to (Type: Pointer to a type defined struct called "IntList").
+ * @param  pCurrTotal: total the recovered operands are added to (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns the amount of records replayed, -1 if the file exists but is not a journal.
+ */
+long recoverJournal( const char* pcPath, IntList* pList, Accumulator* pCurrTotal ) {
+    int fd;
+    struct stat info;
+    char* pcMap;
+    const JournalRecord* pRecord;
+    size_t recordCount, index;
+    int value;
+    long retVal = 0;
+
+    fd = open( pcPath, O_RDONLY );
+    if ( fd < 0 ) {
+        return 0; /* no journal, nothing to recover */
+    }
+
+    if ( fstat( fd, &info ) == 0 && info.st_size > JOURNAL_MAGIC_SIZE ) {
+        pcMap = ( char* ) mmap( NULL, ( size_t ) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if ( pcMap == MAP_FAILED ) {
+            retVal = -1;
+        }
+        else if ( memcmp( pcMap, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE ) != 0 ) {
+            retVal = -1;
+            munmap( pcMap, ( size_t ) info.st_size );
+        }
+        else {
+            /* records start right after the magic, which keeps them aligned */
+            pRecord = ( const JournalRecord* ) ( pcMap + JOURNAL_MAGIC_SIZE );
+            recordCount = ( ( size_t ) info.st_size - JOURNAL_MAGIC_SIZE ) / sizeof( JournalRecord );
+            posix_madvise( pcMap, ( size_t ) info.st_size, POSIX_MADV_SEQUENTIAL );
+
+            for ( index = 0 ; index < recordCount ; index++ ) {
+                if ( pRecord[index].type == JOURNAL_PUSH ) {
+                    insertLastInt( pList, pRecord[index].value );
+                    addAccumulator( pCurrTotal, pRecord[index].value );
+                }
+                else if ( pRecord[index].type == JOURNAL_POP && removeLastInt( pList, &value ) ) {
+                    addAccumulator( pCurrTotal, -( long ) value );
+                }
+                else if ( pRecord[index].type == JOURNAL_POP ) {
+                    fprintf( stderr, "Journal %s: record %lu undoes an operand that was never entered, ignoring it and the %lu records after it\n", 
+                             pcPath, ( unsigned long ) index + 1, ( unsigned long ) ( recordCount - index - 1 ) );
+                    break;
+                }
+                else {
+                    fprintf( stderr, "Journal %s: record %lu is corrupt (type %d), ignoring it and the %lu records after it\n", 
+                             pcPath, ( unsigned long ) index + 1, pRecord[index].type, ( unsigned long ) ( recordCount - index - 1 ) );
+                    break;
+                }
+                retVal++;
+            }
+
+            munmap( pcMap, ( size_t ) info.st_size );
+        }
+    }
+
+    close( fd );
+    return retVal;
+}
+
+
+/**
+ * @brief  opens a journal for appending, creating it if needed.
+ * @note   existing records are kept so a recovered session carries on in the same journal. A journal ending in a torn 
+ * * record is truncated back to the last whole record first. Only an empty file is started as a new journal; any other 
+ * * file that does not begin with JOURNAL_MAGIC is refused, so a wrong path never truncates someone else's file.
+ * @param  pcPath: journal file path (Type: Char array).
+ * @param  syncIntervalMs: longest time in milliseconds a record may wait for fdatasync, 0 to sync every record (Type: Long).
+ * @retval returns the Journal Struct, NULL if the file could not be opened.
+ */
+Journal* openJournal( const char* pcPath, long syncIntervalMs ) {
+    Journal* pJournal;
+    struct stat info;
+    char acMagic[JOURNAL_MAGIC_SIZE];
+    off_t validSize;
+    int fd;
+
+    fd = open( pcPath, O_RDWR | O_CREAT, 0644 );
+    if ( fd < 0 ) {
+        return NULL;
+    }
+
+    if ( fstat( fd, &info ) != 0 ) {
+        close( fd );
+        return NULL;
+    }
+
+    if ( info.st_size == 0 ) { /* new journal */
+        if ( write( fd, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE ) != JOURNAL_MAGIC_SIZE ) {
+            close( fd );
+            return NULL;
+        }
+    }
+    else if ( info.st_size < JOURNAL_MAGIC_SIZE || pread( fd, acMagic, JOURNAL_MAGIC_SIZE, 0 ) != JOURNAL_MAGIC_SIZE 
+              || memcmp( acMagic, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE ) != 0 ) { /* not a journal */
+        close( fd );
+        return NULL;
+    }
+    else { /* drop a torn record left by a crash so new records stay aligned */
+        validSize = JOURNAL_MAGIC_SIZE + ( info.st_size - JOURNAL_MAGIC_SIZE ) / ( off_t ) sizeof( JournalRecord ) * ( off_t ) sizeof( JournalRecord );
+        if ( validSize != info.st_size && ftruncate( fd, validSize ) != 0 ) {
+            close( fd );
+            return NULL;
+        }
+    }
+
+    lseek( fd, 0, SEEK_END );
+
+    pJournal = ( Journal* ) malloc( sizeof( Journal ) );
+    pJournal->fd = fd;
+    pJournal->syncIntervalMs = syncIntervalMs;
+    pJournal->unsynced = 0;
+    clock_gettime( CLOCK_MONOTONIC, &pJournal->lastSync );
+
+    return pJournal;
+}
+
+
+/**
+ * @brief  returns how long until the journal's unsynced records are due for fdatasync.
+ * @note   callers waiting for input wait at most this long, then call syncDueJournal, so records written just before a 
+ * * session goes idle are not held back until the next append.
+ * @param  pJournal: journal to check, may be NULL (Type: Pointer to a type defined struct called "Journal").
+ * @retval returns the milliseconds left, 0 if the sync is overdue, -1 if there is nothing to sync.
+ */
+long journalSyncWaitMs( const Journal* pJournal ) {
+    struct timespec now;
+    long elapsedMs;
+
+    if ( pJournal == NULL || pJournal->unsynced == 0 ) {
+        return -1;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    elapsedMs = ( now.tv_sec - pJournal->lastSync.tv_sec ) * 1000 + ( now.tv_nsec - pJournal->lastSync.tv_nsec ) / 1000000;
+
+    return ( elapsedMs >= pJournal->syncIntervalMs ) ? 0 : pJournal->syncIntervalMs - elapsedMs;
+}
+
+
+/**
+ * @brief  runs fdatasync if the journal has records that have waited syncIntervalMs since the last one.
+ * @param  pJournal: journal to sync, may be NULL (Type: Pointer to a type defined struct called "Journal").
+ * @retval None
+ */
+void syncDueJournal( Journal* pJournal ) {
+    if ( journalSyncWaitMs( pJournal ) == 0 ) {
+        syncJournal( pJournal );
+    }
+}
+
+
+/**
+ * @brief  appends a record to the journal.
+ * @note   the record is handed to the kernel immediately, so it survives the process being killed. fdatasync is batched: 
+ * * it runs here once syncIntervalMs has passed since the last one, and callers waiting for input run it through 
+ * * syncDueJournal when the interval runs out, which bounds what a power loss can take.
+ * @param  pJournal: journal to append to (Type: Pointer to a type defined struct called "Journal").
+ * @param  type: record type, i.e. JOURNAL_PUSH (Type: Integer).
+ * @param  value: operand value (Type: Integer).
+ * @retval returns TRUE if the record was written, FALSE on error.
+ */
+int appendJournal( Journal* pJournal, int type, int value ) {
+    JournalRecord record;
+    ssize_t written;
+
+    record.type = type;
+    record.value = value;
+
+    do {
+        written = write( pJournal->fd, &record, sizeof( record ) );
+    } while ( written < 0 && errno == EINTR );
+
+    if ( written != ( ssize_t ) sizeof( record ) ) {
+        return FALSE;
+    }
+
+    pJournal->unsynced++;
+    syncDueJournal( pJournal );
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  flushes any unsynced journal records to disk.
+ * @param  pJournal: journal to sync (Type: Pointer to a type defined struct called "Journal").
+ * @retval None
+ */
+void syncJournal( Journal* pJournal ) {
+    if ( pJournal->unsynced > 0 ) {
+        fdatasync( pJournal->fd );
+        pJournal->unsynced = 0;
+    }
+    clock_gettime( CLOCK_MONOTONIC, &pJournal->lastSync );
+}
+
+
+/**
+ * @brief  closes the journal and frees it.
+ * @note   pass the journal path once the session has been written to its output file, the journal is then no longer 
+ * * needed and is removed. Pass NULL to keep the journal.
+ * @param  pJournal: journal to close (Type: Pointer to a type defined struct called "Journal").
+ * @param  pcRemovePath: journal file path to remove, or NULL (Type: Char array).
+ * @retval None
+ */
+void closeJournal( Journal* pJournal, const char* pcRemovePath ) {
+    if ( pJournal != NULL ) {
+        syncJournal( pJournal );
+        close( pJournal->fd );
+
+        if ( pcRemovePath != NULL ) {
+            unlink( pcRemovePath );
+        }
+
+        free( pJournal );
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <time.h>
+#include "intList.h"
+#include "accumulator.h"
+
+#define JOURNAL_MAGIC "CALCJNL1"
+#define JOURNAL_MAGIC_SIZE 8
+#define JOURNAL_DEFAULT_SYNC_INTERVAL_MS 1000
+
+#define JOURNAL_PUSH 1 /* operand appended to the history */
+#define JOURNAL_POP 2 /* last operand taken back by undo */
+
+typedef struct JournalRecord
+{
+	int type; /* JOURNAL_PUSH or JOURNAL_POP */
+	int value; /* operand pushed or popped */
+} JournalRecord;
+
+typedef struct Journal
+{
+	int fd; /* journal file opened for appending */
+	long syncIntervalMs; /* longest time a written record may wait for fdatasync, 0 syncs every record */
+	long unsynced; /* records written since the last fdatasync */
+	struct timespec lastSync; /* time of the last fdatasync */
+} Journal;
+
+
+long recoverJournal( const char* pcPath, IntList* pList, Accumulator* pCurrTotal );
+Journal* openJournal( const char* pcPath, long syncIntervalMs );
+int appendJournal( Journal* pJournal, int type, int value );
+long journalSyncWaitMs( const Journal* pJournal );
+void syncDueJournal( Journal* pJournal );
+void syncJournal( Journal* pJournal );
+void closeJournal( Journal* pJournal, const char* pcRemovePath );
+
+#endif
@@ -0,0 +1,143 @@
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "keyQueue.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+
+/**
+ * @brief  initialises an empty single-producer, single-consumer key queue.
+ * @note   exactly one thread may push and one other thread may pop. Neither ever takes a lock: each side owns one 
+ * * counter, publishes it with a release store and reads the other's with an acquire load.
+ * @param  pQueue: queue to initialise (Type: Pointer to a type defined struct called "KeyQueue").
+ * @retval returns TRUE on success.
+ */
+int initKeyQueue( KeyQueue* pQueue ) {
+    pQueue->head = 0;
+    pQueue->tail = 0;
+    pQueue->closed = FALSE;
+
+    return sem_init( &pQueue->ready, 0, 0 ) == 0;
+}
+
+
+/**
+ * @brief  appends keys to the queue and wakes the consumer. Producer only.
+ * @param  pQueue: queue to push to (Type: Pointer to a type defined struct called "KeyQueue").
+ * @param  pcKeys: keys to push (Type: Char array).
+ * @param  count: amount of keys (Type: size_t).
+ * @retval returns the amount of keys pushed, fewer than count if the queue filled up.
+ */
+size_t pushKeys( KeyQueue* pQueue, const char* pcKeys, size_t count ) {
+    unsigned long head = pQueue->head;
+    unsigned long space = KEY_QUEUE_SIZE - ( head - __atomic_load_n( &pQueue->tail, __ATOMIC_ACQUIRE ) );
+    size_t first, index;
+
+    if ( count > space ) {
+        count = space;
+    }
+
+    /* copy in at most two pieces, up to the end of the buffer and then from its start */
+    index = ( size_t ) ( head & ( KEY_QUEUE_SIZE - 1 ) );
+    first = KEY_QUEUE_SIZE - index < count ? KEY_QUEUE_SIZE - index : count;
+    memcpy( pQueue->acKeys + index, pcKeys, first );
+    memcpy( pQueue->acKeys, pcKeys + first, count - first );
+
+    if ( count > 0 ) {
+        __atomic_store_n( &pQueue->head, head + count, __ATOMIC_RELEASE );
+        sem_post( &pQueue->ready );
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief  takes every key waiting in the queue, up to capacity. Consumer only, never blocks.
+ * @param  pQueue: queue to pop from (Type: Pointer to a type defined struct called "KeyQueue").
+ * @param  pcKeys: buffer the keys are copied to (Type: Char array).
+ * @param  capacity: size of pcKeys (Type: size_t).
+ * @retval returns the amount of keys popped, 0 if the queue was empty.
+ */
+size_t popKeys( KeyQueue* pQueue, char* pcKeys, size_t capacity ) {
+    unsigned long tail = pQueue->tail;
+    size_t count = ( size_t ) ( __atomic_load_n( &pQueue->head, __ATOMIC_ACQUIRE ) - tail );
+    size_t first, index;
+
+    if ( count > capacity ) {
+        count = capacity;
+    }
+
+    index = ( size_t ) ( tail & ( KEY_QUEUE_SIZE - 1 ) );
+    first = KEY_QUEUE_SIZE - index < count ? KEY_QUEUE_SIZE - index : count;
+    memcpy( pcKeys, pQueue->acKeys + index, first );
+    memcpy( pcKeys + first, pQueue->acKeys, count - first );
+
+    if ( count > 0 ) {
+        __atomic_store_n( &pQueue->tail, tail + count, __ATOMIC_RELEASE );
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief  sleeps until the producer pushes or closes the queue, or a timeout passes. Consumer only.
+ * @note   may return with nothing to pop (a wakeup for keys already popped, or the timeout), callers simply pop again.
+ * @param  pQueue: queue to wait on (Type: Pointer to a type defined struct called "KeyQueue").
+ * @param  timeoutMs: longest to sleep, -1 for no limit (Type: Long).
+ * @retval None
+ */
+void waitKeys( KeyQueue* pQueue, long timeoutMs ) {
+    struct timespec deadline;
+
+    if ( timeoutMs < 0 ) {
+        while ( sem_wait( &pQueue->ready ) != 0 && errno == EINTR ) {
+        }
+        return;
+    }
+
+    /* sem_timedwait takes an absolute CLOCK_REALTIME deadline */
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += ( timeoutMs % 1000 ) * 1000000L;
+    if ( deadline.tv_nsec >= 1000000000L ) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while ( sem_timedwait( &pQueue->ready, &deadline ) != 0 && errno == EINTR ) {
+    }
+}
+
+
+/**
+ * @brief  marks that no more keys will be pushed and wakes the consumer. Producer only.
+ * @retval None
+ */
+void closeKeyQueue( KeyQueue* pQueue ) {
+    __atomic_store_n( &pQueue->closed, TRUE, __ATOMIC_RELEASE );
+    sem_post( &pQueue->ready );
+}
+
+
+/**
+ * @brief  returns TRUE once the producer has closed the queue.
+ * @note   keys pushed before closing are still there to pop; check this before popping, then an empty pop means the 
+ * * queue is drained for good.
+ * @retval returns TRUE if closed.
+ */
+int keyQueueClosed( KeyQueue* pQueue ) {
+    return __atomic_load_n( &pQueue->closed, __ATOMIC_ACQUIRE );
+}
+
+
+/**
+ * @brief  releases the queue's semaphore.
+ * @retval None
+ */
+void destroyKeyQueue( KeyQueue* pQueue ) {
+    sem_destroy( &pQueue->ready );
+}
@@ -0,0 +1,30 @@
+#ifndef KEYQUEUE_H
+#define KEYQUEUE_H
+
+#include <stddef.h>
+#include <semaphore.h>
+
+#define KEY_QUEUE_SIZE 65536 /* power of two, so positions wrap with a mask */
+#define KEY_QUEUE_CACHE_LINE 64
+
+typedef struct KeyQueue
+{
+	unsigned long head; /* keys ever pushed, written only by the producer */
+	char acHeadPad[KEY_QUEUE_CACHE_LINE - sizeof( unsigned long )]; /* keep head and tail on separate cache lines */
+	unsigned long tail; /* keys ever popped, written only by the consumer */
+	char acTailPad[KEY_QUEUE_CACHE_LINE - sizeof( unsigned long )];
+	int closed; /* set by the producer once no more keys will be pushed */
+	sem_t ready; /* posted after every push, so an idle consumer sleeps rather than spins */
+	char acKeys[KEY_QUEUE_SIZE];
+} KeyQueue;
+
+
+int initKeyQueue( KeyQueue* pQueue );
+size_t pushKeys( KeyQueue* pQueue, const char* pcKeys, size_t count );
+size_t popKeys( KeyQueue* pQueue, char* pcKeys, size_t capacity );
+void waitKeys( KeyQueue* pQueue, long timeoutMs );
+void closeKeyQueue( KeyQueue* pQueue );
+int keyQueueClosed( KeyQueue* pQueue );
+void destroyKeyQueue( KeyQueue* pQueue );
+
+#endif
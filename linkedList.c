@@ -34,12 +34,62 @@ void freeData( void* pData ) {
 LinkedList* createLinkedList() {
     LinkedList* pLinkedList = ( LinkedList* ) malloc( sizeof( LinkedList ) );
     pLinkedList -> head = NULL;
+    pLinkedList -> tail = NULL;
     pLinkedList -> size = 0;
+    pLinkedList -> pArena = NULL;
+    pLinkedList -> pFreeNodes = NULL;
 
     return pLinkedList;
 }
 
 
+/**
+ * @brief  creates the generic linked list backed by an arena.
+ * @note   nodes and data from allocLinkedListData are carved from large blocks instead of one malloc each, and are all 
+ * * released at once by freeLinkedList. Data from allocLinkedListData must not be freed with free().
+ * @param  blockSize: bytes in each arena block, ARENA_DEFAULT_BLOCK_SIZE is used if 0 (Type: size_t).
+ * @retval Returns Linked List Struct.
+ */
+LinkedList* createLinkedListWithArena( size_t blockSize ) {
+    LinkedList* pLinkedList = createLinkedList();
+    pLinkedList -> pArena = createArena( blockSize );
+
+    return pLinkedList;
+}
+
+
+/**
+ * @brief  allocates memory for a value to be stored in the linked list.
+ * @note   uses the linked list's arena if it has one, otherwise malloc.
+ * @param  pList: linked list the data will be inserted into (Type: Pointer to a type defined struct called "LinkedList").
+ * @param  size: amount of bytes needed (Type: size_t).
+ * @retval returns a pointer to the memory.
+ */
+void* allocLinkedListData( LinkedList* pList, size_t size ) {
+    return ( pList->pArena != NULL ) ? arenaAlloc( pList->pArena, size ) : malloc( size );
+}
+
+
+/**
+ * @brief  frees data that was removed from the linked list.
+ * @note   data carved from the linked list's arena is handed back to the arena for the next allocLinkedListData of the 
+ * * same size, otherwise fpFreeDataFunc is called.
+ * @param  pList: linked list the data was removed from (Type: Pointer to a type defined struct called "LinkedList").
+ * @param  pData: data returned by removeLast (Type: Void Pointer).
+ * @param  size: size the data was allocated with by allocLinkedListData (Type: size_t).
+ * @param  fpFreeDataFunc: function pointer used to free the data. (Type: Address of function pointer 'FunPtr' )
+ * @retval None
+ */
+void releaseLinkedListData( LinkedList* pList, void* pData, size_t size, FunPtr fpFreeDataFunc ) {
+    if ( pList->pArena != NULL ) {
+        arenaRelease( pList->pArena, pData, size );
+    }
+    else {
+        ( *fpFreeDataFunc )( pData );
+    }
+}
+
+
 /**
  * @brief  Inserts last to the generic linked list.
  * @note   Inserts a pointer to the corresponding data last to the generic linked list.
@@ -48,9 +98,22 @@ LinkedList* createLinkedList() {
  * @retval None
  */
 void insertLast( LinkedList* pList, void* pData ) {
-	LinkedListNode* pNode = ( LinkedListNode* ) malloc ( sizeof( LinkedListNode ) );
+	LinkedListNode* pNode;
+
+	if ( pList->pFreeNodes != NULL ) { /* reuse a node released by removeLast */
+		pNode = pList->pFreeNodes;
+		pList->pFreeNodes = pNode->next;
+	}
+	else if ( pList->pArena != NULL ) { /* carve a new node from the arena */
+		pNode = ( LinkedListNode* ) arenaAlloc( pList->pArena, sizeof( LinkedListNode ) );
+	}
+	else {
+		pNode = ( LinkedListNode* ) malloc ( sizeof( LinkedListNode ) );
+	}
+
 	pNode->data = pData;
 	pNode->next = NULL;
+	pNode->prev = pList->tail; /* back-link to the current tail, NULL if the list is empty */
 		
 	if ( pList->head == NULL ) { /* if linked list is empty */
 		pList->head = pNode; /* set head to node created */
@@ -66,42 +129,36 @@ void insertLast( LinkedList* pList, void* pData ) {
 
 /**
  * @brief  remove last from the generic linked list.
- * @note   remove last element from the generic linked list. If deleted node data had memory allocations, freeData() should be called after removeLast().
+ * @note   remove last element from the generic linked list in constant time using the tail's back-link. If deleted node data had 
+ * * memory allocations, freeData() should be called after removeLast().
  * @param  pList: linked list that holds pointers (void*) to values as it's data field (Type: Pointer to a type defined struct called "LinkedList").
- * @retval returns void pointer to the value of the removed node.
+ * @retval returns void pointer to the value of the removed node, NULL if the list was empty.
  */
 void* removeLast( LinkedList* pList ) {
     void * retVal = NULL;
-    LinkedListNode* currNode = pList->head; /* start at linked list head */
-
-    while ( currNode ) { /* traverse to the end of the linked list if not empty */
+    LinkedListNode* pLast = pList->tail; /* node to remove */
 
-        if ( pList->size == 1 ) { /* if size of linked list 1 */
-            retVal = currNode->data; /* assign retVal to the node's data*/
+    if ( pLast != NULL ) { /* nothing to remove from an empty linked list */
+        retVal = pLast->data; /* assign retVal to the node's data */
 
-			pList->tail = NULL; /* nullify the tail pointer */
-            free( pList->head ); /* free the head */
-            pList->head = NULL; /* nullify the head, linked list should now be empty */
+        pList->tail = pLast->prev; /* the node before the tail becomes the new tail */
 
-            currNode = NULL; /* exit out of loop */
+        if ( pList->tail == NULL ) { /* removed the only node, linked list is now empty */
+            pList->head = NULL;
         }
-
-        else if ( currNode->next->next == NULL ) { /* if at the end of linked list */
-            retVal = currNode->next->data; /* assign retVal to the node's data */
-
-			pList->tail = currNode; /* update the tail pointer */
-            free( currNode->next ); /* free the next node */
-
-            currNode->next = NULL; /* nullify the currNode's next value */
-
-            currNode = NULL; /* exit out of loop */
+        else {
+            pList->tail->next = NULL; /* nullify the new tail's next value */
         }
 
+        if ( pList->pArena != NULL ) { /* arena nodes cannot be freed individually, keep it for the next insertLast */
+            pLast->next = pList->pFreeNodes;
+            pList->pFreeNodes = pLast;
+        }
         else {
-            currNode = currNode->next; /* else traverse until the end of the linked list */
+            free( pLast ); /* free the removed node */
         }
+        ( pList->size )--; /* decrement the linked list's size field */
     }
-    ( pList->size )--; /* decrement the linked list's size field */
 
     return retVal; /* return the pointer to the value */
 }
@@ -109,7 +166,8 @@ void* removeLast( LinkedList* pList ) {
 
 /**
  * @brief  free the memory allocated for the linked list
- * @note   frees the malloc'ed nodes and uses the freeData function to free the node's data field if necessary
+ * @note   frees the malloc'ed nodes and uses the freeData function to free the node's data field if necessary. If the linked list 
+ * * has an arena, the nodes and data are released with the arena instead
  * @param  pList: linked list that holds pointers (void*) to values as it's data field (Type: Pointer to a type defined struct called "LinkedList").
  * @param  fpFreeDataFunc: function pointer used to free the data malloc'ed for the generic linked list. (Type: Address of function pointer 'FunPtr' )
  * @retval None
@@ -118,6 +176,12 @@ void freeLinkedList( LinkedList* pList, FunPtr fpFreeDataFunc) {
 	LinkedListNode* currNode = pList->head; /* start at the head */
 	LinkedListNode* pTemp; /* temporary storage to traverse the linked list */
 	
+	if ( pList->pArena != NULL ) { /* every node and arena data block goes at once */
+		freeArena( pList->pArena );
+		pList->pArena = NULL;
+		currNode = NULL;
+	}
+
 	while ( currNode ) { /* while currnode exists */
 		pTemp = currNode->next; /* set the temp storage to the next node */
 		
@@ -126,6 +190,7 @@ void freeLinkedList( LinkedList* pList, FunPtr fpFreeDataFunc) {
 		/* Nullify the current node's fields */
 		currNode->data = NULL;
 		currNode->next = NULL;
+		currNode->prev = NULL;
 		free( currNode ); /* free the current node */
 		
 		currNode = pTemp; /* set the current node to the next node to traverse */		
@@ -151,3 +216,32 @@ void printLinkedList( LinkedList* pList, FunPtr fpPrintDataFunc ) {
 	}
 }
 
+
+/**
+ * @brief  starts iterating the linked list from the tail towards the head.
+ * @note   the iterator only holds a node pointer, so it lives on the caller's stack. Removing nodes while iterating is not supported.
+ * @param  pList: linked list to iterate (Type: Pointer to a type defined struct called "LinkedList").
+ * @param  pIter: iterator to initialise (Type: Pointer to a type defined struct called "LinkedListIterator").
+ * @retval None
+ */
+void startReverseIterator( LinkedList* pList, LinkedListIterator* pIter ) {
+	pIter->curr = pList->tail; /* start at the tail */
+}
+
+
+/**
+ * @brief  returns the next data pointer walking from the tail to the head.
+ * @note   each call is constant time, a full walk is linear in the size of the linked list.
+ * @param  pIter: iterator started with startReverseIterator (Type: Pointer to a type defined struct called "LinkedListIterator").
+ * @retval returns the node's data pointer, NULL once the head has been passed.
+ */
+void* nextReverse( LinkedListIterator* pIter ) {
+	void* retVal = NULL;
+
+	if ( pIter->curr != NULL ) {
+		retVal = pIter->curr->data;
+		pIter->curr = pIter->curr->prev; /* step back towards the head */
+	}
+
+	return retVal;
+}
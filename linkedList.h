@@ -1,10 +1,14 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
 
+#include <stddef.h>
+#include "arena.h"
+
 typedef struct LinkedListNode
 {
 	void* data;
 	struct LinkedListNode* next;
+	struct LinkedListNode* prev;
 } LinkedListNode;
 
 typedef struct LinkedList
@@ -12,17 +16,29 @@ typedef struct LinkedList
 	LinkedListNode* head;
 	LinkedListNode* tail;
 	int size;	
+	Arena* pArena; /* optional arena the nodes and data are carved from, NULL to use malloc */
+	LinkedListNode* pFreeNodes; /* arena nodes released by removeLast, reused by insertLast */
 } LinkedList;
 
+typedef struct LinkedListIterator
+{
+	LinkedListNode* curr;
+} LinkedListIterator;
+
 typedef void (*FunPtr)(void* data);
 
 
 LinkedList* createLinkedList();
+LinkedList* createLinkedListWithArena( size_t blockSize );
+void* allocLinkedListData( LinkedList* pList, size_t size );
+void releaseLinkedListData( LinkedList* pList, void* pData, size_t size, FunPtr fpFreeDataFunc );
 void insertLast( LinkedList* pList, void* pData );
 void* removeLast( LinkedList* pList );
 void freeData( void * pData );
 void freeLinkedList( LinkedList* pList, FunPtr fpFreeDataFunc );
 void printData(void* pData);
 void printLinkedList(LinkedList* pList, FunPtr fpPrintDataFunc);
+void startReverseIterator( LinkedList* pList, LinkedListIterator* pIter );
+void* nextReverse( LinkedListIterator* pIter );
 
 #endif
\ No newline at end of file
@@ -1,7 +1,35 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "module.h"
+#include "render.h"
+#include "evaluator.h"
+#include "server.h"
+#include "binfmt.h"
+#include "running.h"
+#include "interactive.h"
+#include "planner.h"
+#include "resume.h"
+
+
+/**
+ * @brief  prints the accepted command line forms.
+ * @retval None
+ */
+static void printUsage() {
+    printf( "Please provide argument correctly: ./calculator [--seed <n>] [--layout <n>] <filename>\n" );
+    printf( "                                   ./calculator --replay <keysfile|-> [--seed <n>] [--layout <n>] <filename>\n" );
+    printf( "                                   ./calculator --type <expression> [--seed <n>] [--layout <n>] <filename>\n" );
+    printf( "                                   ./calculator --eval <infile> <outfile> [--threads <n>]\n" );
+    printf( "                                   ./calculator --serve <socket> [--seed <n>] [--layout <n>] <outprefix>\n" );
+    printf( "Journal options: [--journal <path>] [--no-journal] [--sync-interval <ms>] [--resume]\n" );
+    printf( "Latency options: [--stats] [--trace <tracefile.json>]\n" );
+    printf( "Output options: [--format=text|--format=bin] [--running [--threads <n>]]\n" );
+    printf( "Memory options: [--max-resident-operands <n>]\n" );
+    printf( "Monitor options: [--shm <name>], watch with ./calcmon <name>\n" );
+}
 
 
 int main( int argc, char *argv[] ) {
@@ -12,100 +40,368 @@ int main( int argc, char *argv[] ) {
      * ************************************** */
 
     int randInt; /* value to hold the random integer generated */
-    int currNum = 0; /* current number being displayed on calculator screen */
-    int digitCount = 0; /* value to hold the amount of digits currNum has */
-    int currTotal = 0; /* current total value calculated */
-    int exitStatus = FALSE; /* value to hold that decides if the program has been asked to exit by the user or not */
+    int argIndex; /* index of the command line argument being parsed */
+    int validArgs = TRUE; /* FALSE if the command line could not be parsed */
+    int seedGiven = FALSE, layoutGiven = FALSE; /* TRUE if --seed or --layout were supplied */
+    unsigned int seed = 0; /* seed for the random layout choice */
+    int layout = 0; /* layout requested with --layout */
+    int useJournal = TRUE; /* FALSE if --no-journal was supplied */
+    long syncIntervalMs = JOURNAL_DEFAULT_SYNC_INTERVAL_MS; /* longest a journal record waits for fdatasync */
+    long recovered; /* journal records replayed from an earlier session */
+    long resumed; /* operands restored from the output file by --resume */
+    int resume = FALSE; /* TRUE if --resume was supplied */
+    long flagged; /* lines flagged by --eval */
+    long served; /* sessions served by --serve */
+    long maxResident = 0; /* operands kept in memory with --max-resident-operands, 0 for no limit */
+    int threadCount = 0; /* threads for --eval and --running, 0 for one per processor */
+    int outputFormat = OUTPUT_FORMAT_TEXT; /* OUTPUT_FORMAT_BIN if --format=bin was supplied */
+    int written = FALSE; /* TRUE once the output file holds the session */
+    int exitStatus = 0; /* 1 if the session could not be written to the output file */
+    int useStats = FALSE; /* TRUE if --stats or --trace were supplied */
+    unsigned long startNs = 0; /* start of the phase being measured */
+
+    char* pcOutFile = NULL; /* output file name */
+    char* pcReplayFile = NULL; /* keystroke file to replay, "-" for stdin, NULL for interactive */
+    char* pcTypeText = NULL; /* expression to enter with --type, i.e. "123+45=" */
+    char* pcPlannedKeys = NULL; /* shortest keystrokes entering pcTypeText */
+    long plannedCount; /* keystrokes in pcPlannedKeys, -1 if pcTypeText has a glyph not on the keyboard */
+    int plannedCursor; /* cursor key pcPlannedKeys are planned from, moved along by planKeystrokes */
+    char* pcEvalFile = NULL; /* file of addition sequences to re-total with --eval */
+    char* pcServeSocket = NULL; /* Unix socket to serve sessions on with --serve */
+    char* pcJournalFile = NULL; /* journal file name, defaults to <filename>.journal */
+    char* pcDefaultJournal = NULL; /* malloc'ed default journal file name */
+    char* pcTraceFile = NULL; /* Chrome trace-event file written by --trace */
+    char* pcTempFile = NULL; /* malloc'ed <filename>.tmp the output is written to before it replaces <filename> */
+    char* pcShmName = NULL; /* shared memory name the live state is published under with --shm */
+    Session session; /* calculator keyboard, cursor, display number, total, operand list and journal */
 
-    int* piCurrCursorPos; /* curr position of the cursor */
-    char inputCh; /* character input */
-    char* pcOutFile; /* output file name */
-    char** ppcKeyBoardArray = NULL; /* double pointer to the char array of the calculator keyboard */
+    FILE* pInFile = NULL; /* temporary output file */
+    FILE* pKeyFile = NULL; /* keystroke stream for replay mode */
+    Renderer* pRenderer = NULL; /* differential terminal renderer */
+    Stats* pStats = NULL; /* per-phase latency statistics, NULL unless --stats or --trace */
 
-    FILE* pInFile = NULL; /* output file */
-    LinkedList* pList = NULL; /* linked list struct */
+
+    /* ************************************* *
+     * ---- PARSE COMMAND LINE ARGUMENTS ---- *
+     * ************************************* */
+
+    for ( argIndex = 1 ; argIndex < argc && validArgs ; argIndex++ ) {
+
+        if ( strcmp( argv[argIndex], "--replay" ) == 0 && argIndex + 1 < argc ) {
+            pcReplayFile = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--type" ) == 0 && argIndex + 1 < argc ) {
+            pcTypeText = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--eval" ) == 0 && argIndex + 2 < argc ) {
+            pcEvalFile = argv[++argIndex];
+            pcOutFile = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--serve" ) == 0 && argIndex + 1 < argc ) {
+            pcServeSocket = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--threads" ) == 0 && argIndex + 1 < argc ) {
+            threadCount = atoi( argv[++argIndex] );
+            validArgs = ( threadCount > 0 );
+        }
+        else if ( strcmp( argv[argIndex], "--seed" ) == 0 && argIndex + 1 < argc ) {
+            seed = ( unsigned int ) strtoul( argv[++argIndex], NULL, 10 );
+            seedGiven = TRUE;
+        }
+        else if ( strcmp( argv[argIndex], "--layout" ) == 0 && argIndex + 1 < argc ) {
+            layout = atoi( argv[++argIndex] );
+            layoutGiven = TRUE;
+            validArgs = ( layout >= 0 && layout < KEYBOARD_LAYOUT_COUNT );
+        }
+        else if ( strcmp( argv[argIndex], "--journal" ) == 0 && argIndex + 1 < argc ) {
+            pcJournalFile = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--resume" ) == 0 ) {
+            resume = TRUE;
+        }
+        else if ( strcmp( argv[argIndex], "--no-journal" ) == 0 ) {
+            useJournal = FALSE;
+        }
+        else if ( strcmp( argv[argIndex], "--sync-interval" ) == 0 && argIndex + 1 < argc ) {
+            syncIntervalMs = atol( argv[++argIndex] );
+            validArgs = ( syncIntervalMs >= 0 );
+        }
+        else if ( strcmp( argv[argIndex], "--max-resident-operands" ) == 0 && argIndex + 1 < argc ) {
+            maxResident = atol( argv[++argIndex] );
+            validArgs = ( maxResident > 0 );
+        }
+        else if ( strcmp( argv[argIndex], "--shm" ) == 0 && argIndex + 1 < argc ) {
+            pcShmName = argv[++argIndex];
+        }
+        else if ( strcmp( argv[argIndex], "--format=text" ) == 0 ) {
+            outputFormat = OUTPUT_FORMAT_TEXT;
+        }
+        else if ( strcmp( argv[argIndex], "--format=bin" ) == 0 ) {
+            outputFormat = OUTPUT_FORMAT_BIN;
+        }
+        else if ( strcmp( argv[argIndex], "--running" ) == 0 ) {
+            outputFormat = OUTPUT_FORMAT_RUNNING;
+        }
+        else if ( strcmp( argv[argIndex], "--stats" ) == 0 ) {
+            useStats = TRUE;
+        }
+        else if ( strcmp( argv[argIndex], "--trace" ) == 0 && argIndex + 1 < argc ) {
+            pcTraceFile = argv[++argIndex];
+            useStats = TRUE;
+        }
+        else if ( pcOutFile == NULL && argv[argIndex][0] != '-' ) {
+            pcOutFile = argv[argIndex];
+        }
+        else {
+            validArgs = FALSE;
+        }
+    }
 
 
     /* ************* *
     * ---- MAIN ---- *
     * ************** */
 
-    if ( argc != 2 ) { /* run if argument amount is satisfied */
-        printf( "Please provide argument correctly: ./calculator <filename>\n" );
+    if ( !validArgs || pcOutFile == NULL ) { /* run if argument amount is satisfied */
+        printUsage();
     }
 
-    else {
+    else if ( pcEvalFile != NULL ) {
 
-        /* generate random number */
-        srand( time( NULL ) );
-        randInt = rand() % 2;
+        /* # -- BULK RE-TOTAL -- # */
+        flagged = evaluateFile( pcEvalFile, pcOutFile, threadCount );
 
-        /* set the outfile name to the command line argument */
-        pcOutFile = argv[1];
+        if ( flagged < 0 ) {
+            fprintf( stderr, "Could not evaluate %s into %s\n", pcEvalFile, pcOutFile );
+            return 1;
+        }
+        if ( flagged > 0 ) {
+            fprintf( stderr, "%ld lines flagged\n", flagged );
+            return 1;
+        }
+    }
+
+    else if ( pcServeSocket != NULL ) {
+
+        /* # -- MULTI-SESSION SERVER -- # */
+        srand( seedGiven ? seed : ( unsigned int ) time( NULL ) );
+        served = serveSessions( pcServeSocket, pcOutFile, layoutGiven ? layout : SERVER_RANDOM_LAYOUT, outputFormat, useJournal, syncIntervalMs );
+
+        if ( served < 0 ) {
+            fprintf( stderr, "Could not listen on %s\n", pcServeSocket );
+            return 1;
+        }
+        fprintf( stderr, "Served %ld sessions\n", served );
+    }
+
+    else {
+
+        /* choose the layout; an explicit layout wins, then an explicit seed, replays and typed expressions default to layout 0 so they are reproducible */
+        if ( layoutGiven ) {
+            randInt = layout;
+        }
+        else if ( seedGiven || ( pcReplayFile == NULL && pcTypeText == NULL ) ) {
+            srand( seedGiven ? seed : ( unsigned int ) time( NULL ) );
+            randInt = rand() % KEYBOARD_LAYOUT_COUNT;
+        }
+        else {
+            randInt = 0;
+        }
 
 
         /* ************************************************* *
          * ---- PRE-ALLOCATE MEMORY FOR LIST AND ARRAYS ---- *
          * ************************************************* */
 
-        /* create linked list */
-        pList = createLinkedList();
+        /* create keyboard from the chosen layout, an empty operand list and a total of 0 */
+        initSession( &session, randInt );
+
+        /* keep only the newest operands in memory, older ones are spilled to a temporary file (journal recovery included) */
+        if ( maxResident > 0 && !setIntListResidentLimit( session.pList, maxResident ) ) {
+            fprintf( stderr, "Could not bound the operand history, keeping it all in memory\n" );
+        }
+
+        /* carry on from the operands and total in the output file of an earlier session, any journal is replayed on top */
+        if ( resume ) {
+            if ( ( resumed = resumeSession( pcOutFile, session.pList, &session.total ) ) < 0 ) {
+                fprintf( stderr, "Not a calculator output file, leaving it untouched: %s\n", pcOutFile );
+                freeSession( &session );
+                return 1;
+            }
+
+            if ( resumed > 0 ) {
+                fprintf( stderr, "Resumed %ld operands from %s\n", resumed, pcOutFile );
+            }
+        }
+
+        /* recover operands from a session that ended without writing its output file, then keep journaling to it */
+        if ( useJournal ) {
+            if ( pcJournalFile == NULL ) {
+                pcDefaultJournal = ( char* ) malloc( strlen( pcOutFile ) + strlen( ".journal" ) + 1 );
+                strcpy( pcDefaultJournal, pcOutFile );
+                strcat( pcDefaultJournal, ".journal" );
+                pcJournalFile = pcDefaultJournal;
+            }
+
+            recovered = recoverJournal( pcJournalFile, session.pList, &session.total );
 
-        /* create keyboard */
-        constructKeyboard( &ppcKeyBoardArray, randInt );
+            if ( recovered > 0 ) {
+                fprintf( stderr, "Recovered %ld journal records from %s, %ld operands entered\n", recovered, pcJournalFile, session.pList->size );
+            }
 
-        /* malloc cursor position array */
-        piCurrCursorPos = ( int* ) malloc( sizeof( int ) * 2 );
-        piCurrCursorPos[0] = 1; piCurrCursorPos[1] = 0; /* initialise starting position */
+            if ( recovered < 0 ) {
+                fprintf( stderr, "Not a journal, journaling disabled: %s\n", pcJournalFile );
+            }
+            else if ( ( session.pJournal = openJournal( pcJournalFile, syncIntervalMs ) ) == NULL ) {
+                fprintf( stderr, "Could not open journal, journaling disabled: %s\n", pcJournalFile );
+            }
+        }
+
+        /* publish the live state for calcmon, starting from whatever was resumed or recovered */
+        if ( pcShmName != NULL ) {
+            if ( ( session.pMonitor = openMonitor( pcShmName ) ) == NULL ) {
+                fprintf( stderr, "Could not create shared memory (in use by a running calculator?), monitoring disabled: %s\n", pcShmName );
+            }
+            else {
+                publishMonitor( session.pMonitor, 0, session.keyboard.layout, session.cursorKey, session.currNum, session.pList->size, &session.total );
+            }
+        }
+
+        if ( useStats ) {
+            pStats = createStats( pcTraceFile != NULL );
+        }
 
 
         /* ************************* *
          * ---- CALCULATOR CORE ---- *
          * ************************* */
-        
-        /* # -- CALCULATOR BEGIN -- # */
-        disableBuffer(); /* disable user input from being displayed */
 
-        do {
+        if ( pcTypeText != NULL ) {
+
+            /* # -- TYPED EXPRESSION -- # */
+            pcPlannedKeys = ( char* ) malloc( strlen( pcTypeText ) * PLAN_MAX_KEYS_PER_GLYPH + 1 );
+            plannedCursor = session.cursorKey; /* planned from a copy, only applying the keystrokes moves the session's cursor */
+            plannedCount = planKeystrokes( &session.keyboard, &plannedCursor, pcTypeText, pcPlannedKeys );
+
+            if ( plannedCount < 0 ) {
+                fprintf( stderr, "Can only type the glyphs on the keyboard (0-9 + = - <): %s\n", pcTypeText );
+            }
+            else {
+                /* print the keystrokes so they can be kept and replayed with --replay */
+                fwrite( pcPlannedKeys, 1, ( size_t ) plannedCount, stdout );
+                fflush( stdout );
+                applyKeystrokes( &session, pcPlannedKeys, ( size_t ) plannedCount, pStats );
+            }
+
+            free( pcPlannedKeys );
+            pcPlannedKeys = NULL;
+        }
+
+        else if ( pcReplayFile != NULL ) {
+
+            /* # -- HEADLESS REPLAY -- # */
+            pKeyFile = ( strcmp( pcReplayFile, "-" ) == 0 ) ? stdin : fopen( pcReplayFile, "rb" );
+
+            if ( pKeyFile == NULL ) {
+                fprintf( stderr, "Could not open keystroke file: %s\n", pcReplayFile );
+            }
+            else {
+                replayKeystrokes( pKeyFile, &session, pStats );
+
+                if ( pKeyFile != stdin ) {
+                    fclose( pKeyFile );
+                }
+                pKeyFile = NULL;
+            }
+        }
+
+        else {
+
+            /* # -- CALCULATOR BEGIN -- # */
+            disableBuffer(); /* disable user input from being displayed */
+            pRenderer = createRenderer( STDOUT_FILENO );
 
-            system("clear"); /* refresh terminal */
-            displayCalculator( ppcKeyBoardArray, currNum, currTotal ); /* display calculator user interface */
-            scanf( " %c", &inputCh ); /* get user input (w, a, s, d and e are only valid) */
+            /* keys are read, applied and drawn on separate threads until "=" is confirmed or the input closes */
+            runInteractive( &session, pRenderer, pStats ); /* ends when "=" is confirmed or the input closes */
 
-            /* manages user interface and user's interactions, returns exitStatus; TRUE to exit the program, FALSE to keep looping */ 
-            exitStatus = userInterfaceManager( ppcKeyBoardArray, piCurrCursorPos, &inputCh, &currNum, &digitCount, &currTotal, pList );
-            
-        } while ( exitStatus != TRUE ); /* while not exit menu */
+            /* # -- CALCULATOR END -- # */
+            freeRenderer( pRenderer ); /* return to the normal screen */
+            pRenderer = NULL;
+            enableBuffer(); /* enable user input from being displayed */
+        }
 
-        /* # -- CALCULATOR END -- # */
-        enableBuffer(); /* enable user input from being displayed */
+        /* write to a temporary file first, the output file (maybe the resumed history) is only replaced once it is complete */
+        pcTempFile = ( char* ) malloc( strlen( pcOutFile ) + strlen( ".tmp" ) + 1 );
+        strcpy( pcTempFile, pcOutFile );
+        strcat( pcTempFile, ".tmp" );
 
-        pInFile = fopen( pcOutFile, "w" ); /* open a file to write to */
-        writeDataToFile( pList, pInFile, currTotal, &freeData ); /* write the linked list sequences and total calculated number to file */
+        pInFile = fopen( pcTempFile, "w+b" ); /* open a file to write to, readable too so large outputs can be written through mmap */
+
+        if ( pInFile == NULL ) {
+            fprintf( stderr, "Could not open output file: %s\n", pcTempFile );
+            exitStatus = 1;
+        }
+        else {
+            if ( pStats != NULL ) {
+                startNs = statsNow( pStats );
+            }
+
+            if ( outputFormat == OUTPUT_FORMAT_BIN ) {
+                written = writeBinaryFile( session.pList, pInFile, &session.total ); /* write the operands and total as a binary record */
+            }
+            else if ( outputFormat == OUTPUT_FORMAT_RUNNING ) {
+                written = writeRunningTotals( session.pList, pInFile, &session.total, threadCount ); /* write every operand with its subtotal */
+            }
+            else {
+                written = writeDataToFile( session.pList, pInFile, &session.total ); /* write the list sequences and total calculated number to file */
+            }
+            written = replaceOutputFile( pInFile, pcTempFile, pcOutFile, written );
+            pInFile = NULL;
+
+            if ( pStats != NULL ) {
+                recordPhase( pStats, STATS_PHASE_WRITE, startNs, statsNow( pStats ) );
+            }
+
+            if ( !written ) {
+                fprintf( stderr, "Could not write output file: %s\n", pcOutFile );
+                exitStatus = 1;
+            }
+        }
+        free( pcTempFile );
+        pcTempFile = NULL;
+
+        /* the journal is only removed once the output file holds the session */
+        closeJournal( session.pJournal, written ? pcJournalFile : NULL );
+        session.pJournal = NULL;
+        free( pcDefaultJournal );
+        pcDefaultJournal = NULL;
+
+        /* tell monitors the session has ended */
+        closeMonitor( session.pMonitor );
+        session.pMonitor = NULL;
 
 
         /* ********************************************** *
          * ---- FREE MEMORY ALLOCATED AND FILE CLOSE ---- *
          * ********************************************** */
-        
-         /* free keyboard array */
-        freeKeyboard( ppcKeyBoardArray );
-        ppcKeyBoardArray = NULL;
-
-        /* free cursor position array */
-        free( piCurrCursorPos );
-        piCurrCursorPos = NULL; 
-        
-        /* free linked list */
-        freeLinkedList( pList, &freeData ); 
-        pList = NULL;
-        
-        /* close output file */
-        fclose( pInFile );
-        pInFile = NULL;
+
+        /* report latencies once the terminal is back to normal */
+        if ( pStats != NULL ) {
+            printStats( pStats, stderr, session.pList );
+
+            if ( pcTraceFile != NULL && !writeStatsTrace( pStats, pcTraceFile ) ) {
+                fprintf( stderr, "Could not write trace file: %s\n", pcTraceFile );
+            }
+
+            freeStats( pStats );
+            pStats = NULL;
+        }
+
+        /* free operand list and total */
+        freeSession( &session );
 
     }
 
     /* Program End */
-    return 0;
-}
\ No newline at end of file
+    return exitStatus;
+}
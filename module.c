@@ -1,7 +1,14 @@
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termios.h>
+#include <unistd.h>
 #include "module.h"
+#include "planner.h"
+
+#define REPLAY_BUFFER_SIZE 65536
 
 
 /**
@@ -32,264 +39,439 @@ void enableBuffer() {
 }
 
 
-/**
- * @brief  constructs the calculator keyboard based on a given random integer.
- * @note   constructs the calculator keyboard with supplied pointer to keyboard array and may flip it if the received random integer is 1. 
- * * 50% chance randInt is 1 and 50% change randint is 0. Assumed starting point in table is always table[1][0].
- * @param  pppcKeyBoardArray: pointer to 2D Array of keyboard. (Type: Pointer to a Char 2D array).
- * @param  randInt: Random Integer between 1 and 0. 50% chance randInt is 1 and 50% change randint is 0.
- * @retval None
- */
-void constructKeyboard( char *** pppcKeyBoardArray, int randInt ) {
-    int row; 
-    int rowSize = 8;
-    int colSize = 3;
-    char** table; /* construct table here first then assign to the pointer of ppcKeyBoardArray */
-
-    /* generate 2d Array to hold keyboard elements */
-    table = ( char** ) malloc( sizeof( char* ) * rowSize );
-    
-    for ( row = 0 ; row < rowSize ; row++ ) {
-        table[row] = ( char* ) malloc( sizeof( char ) * colSize );
+/* keyboard layouts, one row per line. Digits and symbols sit on even rows, the cursor moves along the odd row 
+   below them and always starts under the top left key */
+static const char KEYBOARD_LAYOUTS[KEYBOARD_LAYOUT_COUNT][KEYBOARD_SIZE] = {
+    { /* layout 0: 1 2 3 at the top */
+        '1', '2', '3',
+        ' ', ' ', ' ',
+        '4', '5', '6',
+        ' ', ' ', ' ',
+        '7', '8', '9',
+        ' ', ' ', ' ',
+        '+', '0', '=',
+        ' ', ' ', ' ',
+        '-', ' ', '<',
+        ' ', ' ', ' '
+    },
+    { /* layout 1: flipped, + 0 = at the top */
+        '+', '0', '=',
+        ' ', ' ', ' ',
+        '7', '8', '9',
+        ' ', ' ', ' ',
+        '4', '5', '6',
+        ' ', ' ', ' ',
+        '1', '2', '3',
+        ' ', ' ', ' ',
+        '-', ' ', '<',
+        ' ', ' ', ' '
     }
+};
 
-    /* assign digits and symbols to array */
-    table[0][0] = '1'; table[0][1] = '2'; table[0][2] = '3'; 
 
-    table[1][0] = '^'; table[1][1] = ' '; table[1][2] = ' '; 
+/* key transitions and all-pairs shortest cursor paths for each layout, built the first time the layout is constructed */
+static KeyTransition keyTransitions[KEYBOARD_LAYOUT_COUNT][KEY_COUNT][256];
+static KeyPath keyPaths[KEYBOARD_LAYOUT_COUNT][KEY_COUNT][KEY_COUNT];
+static int transitionsBuilt[KEYBOARD_LAYOUT_COUNT];
 
-    table[2][0] = '4'; table[2][1] = '5'; table[2][2] = '6'; 
 
-    table[3][0] = ' '; table[3][1] = ' '; table[3][2] = ' '; 
+/**
+ * @brief  precomputes the (key under cursor, input byte) -> (next key, action) table of a layout, then the shortest 
+ * * cursor path between every pair of keys from it.
+ * @note   movement stops at the keyboard edges, 'e' takes its action from the glyph above the cursor and every other 
+ * * byte does nothing.
+ * @param  layout: layout index between 0 and KEYBOARD_LAYOUT_COUNT - 1 (Type: Integer).
+ * @retval None
+ */
+static void buildTransitions( int layout ) {
+    const char* pcCells = KEYBOARD_LAYOUTS[layout];
+    KeyTransition* pTransition;
+    int key, input, row, col;
+    char glyph;
+
+    for ( key = 0 ; key < KEY_COUNT ; key++ ) {
+        row = key / KEYBOARD_COLS;
+        col = key % KEYBOARD_COLS;
+        glyph = pcCells[KEY_GLYPH_CELL( key )];
+
+        for ( input = 0 ; input < 256 ; input++ ) {
+            pTransition = &keyTransitions[layout][key][input];
+            pTransition->next = ( unsigned char ) key;
+            pTransition->action = ACTION_NONE;
+            pTransition->digit = 0;
+
+            switch ( input ) {
+                case 'w': /* move up unless already on the first key row */
+                    if ( row > 0 ) {
+                        pTransition->next = ( unsigned char ) ( key - KEYBOARD_COLS );
+                    }
+                    break;
 
-    table[4][0] = '7'; table[4][1] = '8'; table[4][2] = '9'; 
+                case 'a': /* move left unless already on the first column */
+                    if ( col > 0 ) {
+                        pTransition->next = ( unsigned char ) ( key - 1 );
+                    }
+                    break;
 
-    table[5][0] = ' '; table[5][1] = ' '; table[5][2] = ' '; 
+                case 's': /* move down unless already on the last key row */
+                    if ( row < KEY_COUNT / KEYBOARD_COLS - 1 ) {
+                        pTransition->next = ( unsigned char ) ( key + KEYBOARD_COLS );
+                    }
+                    break;
 
-    table[6][0] = '+'; table[6][1] = '0'; table[6][2] = '='; 
+                case 'd': /* move right unless already on the last column */
+                    if ( col < KEYBOARD_COLS - 1 ) {
+                        pTransition->next = ( unsigned char ) ( key + 1 );
+                    }
+                    break;
 
-    table[7][0] = ' '; table[7][1] = ' '; table[7][2] = ' '; 
+                case 'e': /* confirm the key above the cursor */
+                    if ( glyph == '=' ) {
+                        pTransition->action = ACTION_EQUALS;
+                    }
+                    else if ( glyph == '+' ) {
+                        pTransition->action = ACTION_ADD;
+                    }
+                    else if ( glyph == '-' ) {
+                        pTransition->action = ACTION_UNDO;
+                    }
+                    else if ( glyph == '<' ) {
+                        pTransition->action = ACTION_BACKSPACE;
+                    }
+                    else if ( glyph >= '0' && glyph <= '9' ) {
+                        pTransition->action = ACTION_DIGIT;
+                        pTransition->digit = ( unsigned char ) ( glyph - '0' );
+                    }
+                    break;
+            }
+        }
+    }
 
-    /* 50% chance randInt is 0, 50% chance randInt is 1, if randInt is 1 then flip the table layout 
-       randomness should be determined in main */
-    if ( randInt == 1 ) {
-        table[6][0] = '1'; table[6][1] = '2'; table[6][2] = '3'; 
-        table[0][0] = '+'; table[0][1] = '0'; table[0][2] = '='; 
+    buildKeyPaths( ( const KeyTransition ( * )[256] ) keyTransitions[layout], keyPaths[layout] );
+    transitionsBuilt[layout] = TRUE;
+}
 
-        table[4][0] = '4'; table[4][1] = '5'; table[4][2] = '6'; 
-        table[2][0] = '7'; table[2][1] = '8'; table[2][2] = '9'; 
 
+/**
+ * @brief  constructs the calculator keyboard from one of the compile-time layouts.
+ * @note   copies the layout's glyphs into the keyboard's flat KEYBOARD_SIZE buffer, indexed by row * KEYBOARD_COLS + col, and 
+ * * points it at the layout's transition and cursor path tables (built on first use, so construct each layout once before starting threads). 
+ * * No memory is allocated. Layout 0 has 1 2 3 at the top, layout 1 is flipped; the layout should be chosen (randomly or not) in main.
+ * @param  pKeyboard: keyboard to fill. (Type: Pointer to a type defined struct called "Keyboard").
+ * @param  layout: layout index between 0 and KEYBOARD_LAYOUT_COUNT - 1 (Type: Integer).
+ * @retval None
+ */
+void constructKeyboard( Keyboard* pKeyboard, int layout ) {
+    if ( !transitionsBuilt[layout] ) {
+        buildTransitions( layout );
     }
 
-    *pppcKeyBoardArray = table; /* make the pointer of the 2d keyboard array, point to table */
+    pKeyboard->layout = layout;
+    memcpy( pKeyboard->acCells, KEYBOARD_LAYOUTS[layout], KEYBOARD_SIZE );
+    pKeyboard->paTransitions = ( const KeyTransition ( * )[256] ) keyTransitions[layout];
+    pKeyboard->paPaths = ( const KeyPath ( * )[KEY_COUNT] ) keyPaths[layout];
 }
 
 
 /**
- * @brief  frees memory allocated for the keyboard generated (using constructKeyboard function).
- * @note   frees memory allocated for the keyboard generated supplied in a pointer to the array (using constructKeyboard function)
- * @param  ppcKeyBoardArray: 2D array of calculator keyboard. (Type: Char 2D array).
+ * @brief  starts a calculator session with an empty history.
+ * @note   the cursor starts under the top left key with 0 on display and a total of 0. The session has no journal or 
+ * * monitor; set pJournal or pMonitor after opening one.
+ * @param  pSession: session to initialise (Type: Pointer to a type defined struct called "Session").
+ * @param  layout: keyboard layout index between 0 and KEYBOARD_LAYOUT_COUNT - 1 (Type: Integer).
  * @retval None
  */
-void freeKeyboard ( char** ppcKeyBoardArray ) {
-    int row;
-    int rowSize = 8;
-    
-    if ( ppcKeyBoardArray != NULL ) { /* check if keyboard array has been assigned/malloc'ed yet */
+void initSession( Session* pSession, int layout ) {
+    constructKeyboard( &pSession->keyboard, layout );
+    pSession->cursorKey = KEYBOARD_START_KEY;
+    pSession->currNum = 0;
+    pSession->digitCount = 0;
+    initAccumulator( &pSession->total );
+    pSession->pList = createIntList();
+    pSession->pJournal = NULL;
+    pSession->pMonitor = NULL;
+}
 
-        /* free every row */
-        for ( row = 0 ; row < rowSize ; row++ )
-            {
-                free( ppcKeyBoardArray[row] );
-                ppcKeyBoardArray[row] = NULL;
-            }
-        
-        /* free the keyboard array */
-        free( ppcKeyBoardArray );
-        ppcKeyBoardArray = NULL;
-    }
+
+/**
+ * @brief  frees a session's operand list and total.
+ * @note   the journal is left to the caller, which knows whether the output file was written and the journal can be removed.
+ * @param  pSession: session to free (Type: Pointer to a type defined struct called "Session").
+ * @retval None
+ */
+void freeSession( Session* pSession ) {
+    freeIntList( pSession->pList );
+    pSession->pList = NULL;
+    freeAccumulator( &pSession->total );
 }
 
 
 /**
- * @brief  displays the calculator keyboard in the character 2d array.
- * @note   prints out the calculator with the given array, current display number and current total
- * @param  ppcKeyBoardArray: 2D array of calculator keyboard. (Type: Char 2D array).
- * @param  currNum: Current display number (Type: Integer).
- * @param  currTotal: Current calculated total (Type: Integer).
+ * @brief  displays the calculator keyboard in the flat character array.
+ * @note   prints out the calculator with the session's keyboard, cursor, current display number and current total
+ * @param  pSession: calculator session to display (Type: Pointer to a type defined struct called "Session").
  * @retval None
  */
-void displayCalculator( char** ppcKeyBoardArray, int currNum, int currTotal ) {
+void displayCalculator( const Session* pSession ) {
 
     int row, col;
-    int rowSize = 8, colSize = 3;
 
-    printf( "---------\n|%7d|\n---------\n", currNum ); /* top box display */
+    printf( "---------\n|%7d|\n---------\n", pSession->currNum ); /* top box display */
     printf( "\n" );
 
-    /* iterate through 2D array and output out */
-    for ( row = 0 ;  row < rowSize ; row++ ) {
+    /* iterate through the keyboard rows and output out */
+    for ( row = 0 ;  row < KEYBOARD_ROWS ; row++ ) {
 
-        for ( col = 0 ;  col < colSize ; col++ ) {
+        for ( col = 0 ;  col < KEYBOARD_COLS ; col++ ) {
 
-            printf( "%c ", ppcKeyBoardArray[row][col] );
+            if ( row * KEYBOARD_COLS + col == KEY_CURSOR_CELL( pSession->cursorKey ) ) {
+                printf( "%c ", KEYBOARD_CURSOR );
+            }
+            else {
+                printf( "%c ", pSession->keyboard.acCells[row * KEYBOARD_COLS + col] );
+            }
         
         }
 
         printf( "\n" );
     }
     
-    printf( "\ncurrent total : %d\n", currTotal ); /* print total */
+    printf( "\ncurrent total : " ); /* print total */
+    printAccumulator( stdout, &pSession->total );
+    printf( "\n" );
 
 }
 
 
 /**
  * @brief  User Interface control manager that takes a character input to perform the actions 
- * * demanded by the user (traverse keyboard, add, equate, etc..).
- * @note   Keyboard size is assumed to be the equal in all functions and related files. Directly above the current user's 
- * * cursor (represented by '^') in the keyboard array is always assumed to be a valid number or arithmetic operation.
- * @param  ppcKeyBoardArray: 2D array of calculator keyboard. (Type: Char 2D array).
- * @param  pcInputCh: user input (i.e. w,a,s or d). (Type: Pointer to the Char input value).
- * @param  piCurrCursorPos: array holding current position of cursor (Type: Pointer to the Char input value).
- * @param  piCurrNum: current display number in the calculator (Type: Pointer to the Char input value).
- * @param  piCurrTotal: current total calculated number in the calculator (Type: Pointer to the Char input value).
- * @param  piDigitCount: current digit count of the display number (Type: Pointer to the Char input value). 
- * @param  pList: linked list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "LinkedList").
+ * * demanded by the user (traverse keyboard, add, undo, backspace, equate, etc..).
+ * @note   Each input is a single lookup in the layout's transition table, which gives the key the cursor moves to and the 
+ * * action to perform; the keyboard glyphs are never inspected or modified here.
+ * @param  pSession: calculator session; its cursor, display number, digit count, total, list and journal are updated (Type: Pointer to a type defined struct called "Session").
+ * @param  pcInputCh: user input (i.e. w,a,s,d or e). (Type: Pointer to the Char input value).
  * @retval returns TRUE or FALSE depending if the calculator program should end or not (based on user input, inputting "=" in the calculator.
  *  will end the program.* )
  */
-int userInterfaceManager( char** ppcKeyBoardArray, int* piCurrCursorPos, char* pcInputCh, int* piCurrNum, int* piDigitCount, int* piCurrTotal, LinkedList* pList ) {
+int userInterfaceManager( Session* pSession, char* pcInputCh ) {
     int retExit = FALSE; /* return Exit Status. End program (user is done with calculator program by inputting "=") if retExit = TRUE */
-    
-    switch ( *pcInputCh ) { 
-        
-        /* KEYBOARD TRAVERSING */
-        case 'w': /* move up */
-            if ( piCurrCursorPos[0] != 1 ) { /* if cursor is not already on the first traversable row */
-                /* update current position of cursor */
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = ' ';
-                piCurrCursorPos[0] = piCurrCursorPos[0] - 2;
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = '^';   
-            }
+    int value; /* operand taken back by undo */
+    const KeyTransition* pTransition = &pSession->keyboard.paTransitions[pSession->cursorKey][( unsigned char ) *pcInputCh];
+
+    pSession->cursorKey = pTransition->next; /* move the cursor, unchanged for anything but w, a, s and d */
+
+    switch ( pTransition->action ) { 
+
+        case ACTION_EQUALS: /* cursor is on '=' */
+            retExit = TRUE; /* exit the code */
             break;
 
-        case 'a': /* move left */
-            if ( piCurrCursorPos[1] != 0 ) { /* if cursor is not already on the first column */
-                /* update current position of cursor */
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = ' ';
-                piCurrCursorPos[1] = piCurrCursorPos[1] - 1;
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = '^';
+        case ACTION_ADD: /* cursor is on '+' */
+            if ( pSession->currNum != 0 ) { /* if the current displayed number is not 0 */
+                /* if displayed number is 0, do not add to the list, no point adding */
+
+                insertLastInt( pSession->pList, pSession->currNum ); /* insert display number by value to last position in the list */
+                if ( pSession->pJournal != NULL ) {
+                    appendJournal( pSession->pJournal, JOURNAL_PUSH, pSession->currNum ); /* record the operand before it can be lost */
+                }
+                addAccumulator( &pSession->total, pSession->currNum ); /* add to current total */
+
+                /* reset current display number */ 
+                pSession->currNum = 0; 
+                pSession->digitCount = 0;
             }
             break;
 
-        case 's': /* move down */
-            if ( piCurrCursorPos[0] != 7 ) { /* if cursor is not already on the last traversable row */
-                /* update current position of cursor */
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = ' ';
-                piCurrCursorPos[0] = piCurrCursorPos[0] + 2;
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = '^';   
+        case ACTION_UNDO: /* cursor is on '-', take back the last operand pushed with '+' */
+            if ( removeLastInt( pSession->pList, &value ) ) { /* constant time, however long the history is */
+                if ( pSession->pJournal != NULL ) {
+                    appendJournal( pSession->pJournal, JOURNAL_POP, value );
+                }
+                addAccumulator( &pSession->total, -( long ) value ); /* subtract from current total */
             }
             break;
 
-        case 'd': /* move right */
-            if ( piCurrCursorPos[1] != 2 ) { /* if cursor is not already on the last column */
-                /* update current position of cursor */
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = ' ';
-                piCurrCursorPos[1] = piCurrCursorPos[1] + 1;
-                ppcKeyBoardArray[piCurrCursorPos[0]][piCurrCursorPos[1]] = '^';
+        case ACTION_BACKSPACE: /* cursor is on '<', drop the last digit of the current display number */
+            pSession->currNum /= 10;
+            if ( pSession->digitCount > 0 ) {
+                pSession->digitCount -= 1; /* reaches 0 together with currNum, as leading zeros are never counted */
             }
             break;
 
-        /* KEYBOARD INPUT CONFIRM */
-        case 'e': /* confirm the input as the current character the user's cursor is pointing to */
-
-            /* if cursor is currently on '=', */
-            if ( ppcKeyBoardArray[piCurrCursorPos[0] - 1][piCurrCursorPos[1]] == '=' ) { 
-                retExit = TRUE; /* exit the code */
-            }
+        case ACTION_DIGIT: /* cursor is on a digit, modify current display number */
+            if ( pSession->digitCount != 7 ) { /* if digit count is not 7, maximum displayable digits is 7 */
 
-            /* if cursor is currently on '+', */
-            else if ( ppcKeyBoardArray[piCurrCursorPos[0] - 1][piCurrCursorPos[1]] == '+' ) {
-                if ( * piCurrNum != 0 ) { /* if the current displayed number is not 0 */
-                    /* if displayed number is 0, do not add to linked list/ malloc-ing, no point adding */
-                    
-                    /* allocate memory for int * to assign to the linked list's void * data */
-                    int * linkedListData = malloc( sizeof ( int * ) );                     
-                    *linkedListData = *piCurrNum; /* assign to the current display number */
-
-                    insertLast( pList, linkedListData ); /* insert display number to last posiiton in the linked list */
-                    *piCurrTotal += *piCurrNum; /* add to current total */ 
-
-                    /* reset current display number */ 
-                    *piCurrNum = 0; 
-                    *piDigitCount = 0;
-                }
-            }
+                /* append the digit to the current displayed number; i.e. confirmed digit: 5, displayed number: 342 -> 3425 */
+                pSession->currNum = pSession->currNum * 10 + pTransition->digit;
 
-            /* else if cursor is not on '+' or '=' then modify current display number */
-            else {
-                if ( *piDigitCount != 7 ) { /* if digit count is not 7, maximum displayable digits is 7 */
-
-                    /* algorithm to append current input number to the current displayed number */
-                    *piCurrNum *= 10; /* move the current display value to the next higher place value, 
-                       i.e. displayed number: 342 -> 3420 */
-
-                    /* add the current number cursor is on to the current displayed number; 
-                       i.e. confirmed number cursor is on: 5, displayed number: 3420 -> 3425 */
-                    *piCurrNum += ( int ) ppcKeyBoardArray[piCurrCursorPos[0] - 1][piCurrCursorPos[1]] - 48;
-                    /* typecast integer then subtract 48 to get the integer version of the ASCII character */
-                    
-                    /* if current display number is not 0 then increase digit count. If the current display 
-                       number is still 0 however, the above won't have any effect (i.e. 0*10 = 0, 48-48 = 0) */
-                    if ( *piCurrNum != 0 ) {
-                        *piDigitCount += 1; /* increase digit count */
-                    }
+                /* if current display number is not 0 then increase digit count. If the current display 
+                   number is still 0 however, the above won't have any effect (i.e. 0*10 + 0 = 0) */
+                if ( pSession->currNum != 0 ) {
+                    pSession->digitCount += 1; /* increase digit count */
                 }
             }
             break;
     }
+
+    if ( pSession->pMonitor != NULL ) { /* stores to shared memory only, no system call */
+        publishMonitor( pSession->pMonitor, 1, pSession->keyboard.layout, pSession->cursorKey, pSession->currNum, pSession->pList->size, &pSession->total );
+    }
+
     return retExit; /* return exit status */
 }
 
 
 /**
- * @brief  Write calculated data and linked list data in sequence to a specified output file and free the data of any nodes removed in linked list.
- * @note   Frees the data in the node using a function pointer, data is of type void * so a special function is needed for this. 
- * @param  pList: linked list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "LinkedList").
+ * @brief  Write calculated data and list data in sequence to a specified output file.
+ * @note   The list is walked from the last value to the first and is left unchanged. The exact size of the text is computed 
+ * * first and it is formatted into a single buffer (or straight into the mapped file for very large histories) and 
+ * * handed to the file's descriptor in one write, rather than through stdio. Anything already buffered in pInFile is 
+ * * flushed first so the text lands after it. With one operand or none only the total is written, so entering 700 and 
+ * * pressing "=" gives '700' rather than '700 = 700'.
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
  * @param  pInFile: output file used for writing the addition sequences and final calculated sum of the program to the file. (Type: Pointer to the type 'FILE').
- * @param  currTotal: value that holds the current total calculated value (Type: Integer).
- * @param  fpFreeDataFunc: function pointer used for freeing the data stored in the void pointer of the linked list's nodes (Type: Address of function pointer 'FunPtr').
+ * @param  pCurrTotal: value that holds the current total calculated value (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns TRUE if the whole sequence was written.
+ */
+int writeDataToFile( IntList* pList, FILE* pInFile, const Accumulator* pCurrTotal ) {
+    if ( fflush( pInFile ) != 0 ) {
+        return FALSE;
+    }
+
+    return writeSerializedSession( fileno( pInFile ), pList, pCurrTotal );
+}
+
+
+/**
+ * @brief  Waits for input on a file descriptor, syncing the journal whenever its interval runs out in the meantime.
+ * @note   Returns at once when the journal has nothing to sync, the read that follows then does the waiting. Keeps an idle 
+ * * session's last journal records from waiting for fdatasync longer than the sync interval.
+ * @param  fd: descriptor keystrokes are read from (Type: Integer).
+ * @param  pJournal: session journal, or NULL (Type: Pointer to a type defined struct called "Journal").
  * @retval None
  */
-void writeDataToFile( LinkedList* pList, FILE* pInFile, int currTotal, FunPtr fpFreeDataFunc ) {
-        
-    if ( pList->size > 1 ) { /* if size is greater than 1, addition sequences are involved */
-        while ( pList->head != NULL ) { /* loop while list is not empty */
+void waitForKeystrokes( int fd, Journal* pJournal ) {
+    struct pollfd waiting;
+    long waitMs;
+
+    waiting.fd = fd;
+    waiting.events = POLLIN;
+
+    while ( ( waitMs = journalSyncWaitMs( pJournal ) ) >= 0 && poll( &waiting, 1, ( int ) waitMs ) == 0 ) {
+        syncDueJournal( pJournal );
+    }
+}
 
-            void * retVal = removeLast( pList ); /* remove the last element in the linked list */
-            int value = *( ( int* ) retVal ); /* type cast to an integer */
 
-            fprintf( pInFile, "%d", value ); /* output the integer to the file */
+/**
+ * @brief  Reads every keystroke that is already waiting on a file descriptor.
+ * @note   Blocks until at least one byte arrives, then keeps draining without blocking until nothing more is queued or the 
+ * * buffer is full, so pasted or auto-repeated keys are handed over as one batch. Uses read() directly, so it must not be 
+ * * mixed with stdio reads on the same descriptor.
+ * @param  fd: descriptor to read from, i.e. STDIN_FILENO in the non-canonical mode set by disableBuffer (Type: Integer).
+ * @param  pcKeys: buffer the keystrokes are stored in (Type: Char array).
+ * @param  capacity: size of pcKeys (Type: size_t).
+ * @retval returns the number of keystrokes read, 0 once the input has closed.
+ */
+size_t readKeystrokes( int fd, char* pcKeys, size_t capacity ) {
+    struct pollfd waiting;
+    ssize_t bytesRead;
+    size_t count = 0;
 
-            ( *fpFreeDataFunc )( retVal ); /* free the malloc'ed data in the void pointer */
+    do {
+        bytesRead = read( fd, pcKeys, capacity );
+    } while ( bytesRead < 0 && errno == EINTR );
 
-            if ( pList->size > 0 ) { 
-                /* if the linked list size is greater than 0 add the '+' sign. Will not 
-                add if last value in linked list was just added. Prevents the following bad output; '1 + 2 + 3 +  = 6' */ 
+    if ( bytesRead <= 0 ) {
+        return 0;
+    }
+    count = ( size_t ) bytesRead;
 
-                fprintf( pInFile, " + " ); /* add the '+' sign */
-            }
+    waiting.fd = fd;
+    waiting.events = POLLIN;
 
+    while ( count < capacity && poll( &waiting, 1, 0 ) > 0 && ( waiting.revents & POLLIN ) ) {
+        if ( ( bytesRead = read( fd, pcKeys + count, capacity - count ) ) <= 0 ) {
+            break;
         }
+        count += ( size_t ) bytesRead;
+    }
 
-        /* add the equal sign and current total if original size of linked list is greater than 1 */
-        fprintf( pInFile, " = %d\n", currTotal );
+    return count;
+}
+
+
+/**
+ * @brief  Feeds a batch of keystrokes through the user interface manager.
+ * @note   Stops at the first '=' confirmation, any keys after it are ignored.
+ * @param  pSession: calculator session the keystrokes are applied to (Type: Pointer to a type defined struct called "Session").
+ * @param  pcKeys: keystrokes to apply (Type: Char array).
+ * @param  count: number of keystrokes in pcKeys (Type: size_t).
+ * @param  pStats: statistics each keystroke is timed into, or NULL to not time them (Type: Pointer to a type defined struct called "Stats").
+ * @retval returns TRUE if the batch confirmed "=", FALSE otherwise.
+ */
+int applyKeystrokes( Session* pSession, char* pcKeys, size_t count, Stats* pStats ) {
+    size_t index;
+    int retExit = FALSE;
+    unsigned long startNs, endNs;
+
+    if ( pStats == NULL ) {
+        for ( index = 0 ; index < count && retExit != TRUE ; index++ ) {
+            retExit = userInterfaceManager( pSession, &pcKeys[index] );
+        }
+    }
+    else {
+        endNs = statsNow( pStats );
+
+        for ( index = 0 ; index < count && retExit != TRUE ; index++ ) {
+            startNs = endNs;
+            retExit = userInterfaceManager( pSession, &pcKeys[index] );
+            endNs = statsNow( pStats );
+            recordPhase( pStats, STATS_PHASE_DISPATCH, startNs, endNs );
+        }
+    }
+
+    return retExit;
+}
+
+
+/**
+ * @brief  Replays a recorded keystroke stream through the user interface manager without any terminal output.
+ * @note   Reads the stream in large blocks and feeds every byte to userInterfaceManager, stopping at the first '=' confirmation 
+ * * or at end of stream. No screen clearing, displaying or terminal mode changes are performed, so this is safe to run headless.
+ * @param  pKeyFile: stream of w, a, s, d and e keystrokes, any other bytes are ignored (Type: Pointer to the type 'FILE').
+ * @param  pSession: calculator session the keystrokes are applied to (Type: Pointer to a type defined struct called "Session").
+ * @param  pStats: statistics each block read and keystroke is timed into, or NULL to not time them (Type: Pointer to a type defined struct called "Stats").
+ * @retval returns TRUE if the stream confirmed "=", FALSE if the stream ended first.
+ */
+int replayKeystrokes( FILE* pKeyFile, Session* pSession, Stats* pStats ) {
+    char acBuffer[REPLAY_BUFFER_SIZE]; /* block of keystrokes read from the stream */
+    ssize_t bytesRead;
+    int retExit = FALSE;
+    unsigned long startNs = 0;
+
+    if ( pStats != NULL ) {
+        startNs = statsNow( pStats );
     }
 
-    else { /* else don't add equal sign, just write the current total number to the file */
-        fprintf( pInFile, "%d\n", currTotal ); 
-        /* this is so that if we just enter 700 in the calculator and exit (press '='), we don't get '700 = 700', we get just '700'*/
+    /* read() rather than fread() so keystrokes arriving on a pipe are applied as soon as they arrive */
+    while ( retExit != TRUE ) {
+        waitForKeystrokes( fileno( pKeyFile ), pSession->pJournal );
+
+        if ( ( bytesRead = read( fileno( pKeyFile ), acBuffer, REPLAY_BUFFER_SIZE ) ) <= 0 ) {
+            break;
+        }
+
+        if ( pStats != NULL ) {
+            recordPhase( pStats, STATS_PHASE_INPUT, startNs, statsNow( pStats ) );
+        }
+
+        retExit = applyKeystrokes( pSession, acBuffer, ( size_t ) bytesRead, pStats );
 
+        if ( pStats != NULL ) {
+            startNs = statsNow( pStats );
+        }
     }
-}
\ No newline at end of file
+
+    return retExit;
+}
@@ -4,15 +4,87 @@
 
 #define FALSE 0
 #define TRUE !FALSE
+
+#define KEYBOARD_ROWS 10
+#define KEYBOARD_COLS 3
+#define KEYBOARD_SIZE ( KEYBOARD_ROWS * KEYBOARD_COLS )
+#define KEYBOARD_LAYOUT_COUNT 2
+#define INPUT_BATCH_SIZE 4096 /* most keystrokes applied between two frames */
+
+#define OUTPUT_FORMAT_TEXT 0 /* "a + b + c = total" line written by writeDataToFile */
+#define OUTPUT_FORMAT_BIN 1 /* varint record written by writeBinaryFile */
+#define OUTPUT_FORMAT_RUNNING 2 /* "operand -> subtotal" lines written by writeRunningTotals */
+
+#define KEY_COUNT ( KEYBOARD_SIZE / 2 ) /* keys sit on even rows, the cursor moves along the odd row below them */
+#define KEYBOARD_START_KEY 0 /* cursor starts under the top left key */
+#define KEY_GLYPH_CELL( key ) ( ( ( key ) / KEYBOARD_COLS * 2 ) * KEYBOARD_COLS + ( key ) % KEYBOARD_COLS )
+#define KEY_CURSOR_CELL( key ) ( KEY_GLYPH_CELL( key ) + KEYBOARD_COLS )
+#define KEYBOARD_CURSOR '^'
+#define KEY_PATH_MAX_MOVES ( KEY_COUNT - 1 ) /* a shortest path never passes the same key twice */
+#define KEY_PATH_UNREACHABLE 0xFF
+
+/* what confirming a key does, precomputed per layout */
+#define ACTION_NONE 0
+#define ACTION_DIGIT 1
+#define ACTION_ADD 2
+#define ACTION_EQUALS 3
+#define ACTION_UNDO 4
+#define ACTION_BACKSPACE 5
+
+#include <stdio.h>
 #include "linkedList.h"
+#include "intList.h"
+#include "journal.h"
+#include "accumulator.h"
+#include "stats.h"
+#include "serialize.h"
+#include "monitor.h"
+
+typedef struct KeyTransition
+{
+	unsigned char next; /* key the cursor is under after the input */
+	unsigned char action; /* ACTION_NONE, ACTION_DIGIT, ACTION_ADD, ACTION_EQUALS, ACTION_UNDO or ACTION_BACKSPACE */
+	unsigned char digit; /* value of the digit for ACTION_DIGIT */
+} KeyTransition;
+
+typedef struct KeyPath
+{
+	unsigned char length; /* moves in acMoves, KEY_PATH_UNREACHABLE if the cursor cannot get there */
+	char acMoves[KEY_PATH_MAX_MOVES]; /* w, a, s and d bytes of a shortest cursor path */
+} KeyPath;
+
+typedef struct Keyboard
+{
+	int layout; /* index into the compile-time layouts */
+	char acCells[KEYBOARD_SIZE]; /* glyphs of the layout, indexed by row * KEYBOARD_COLS + col, the cursor is not stored here */
+	const KeyTransition ( *paTransitions )[256]; /* [key under the cursor][input byte] */
+	const KeyPath ( *paPaths )[KEY_COUNT]; /* [key under the cursor][key to go to], shortest cursor moves */
+} Keyboard;
+
+typedef struct Session
+{
+	Keyboard keyboard; /* glyphs and transition table of the session's layout */
+	int cursorKey; /* key the cursor is currently under */
+	int currNum; /* current number being displayed on calculator screen */
+	int digitCount; /* amount of digits currNum has */
+	Accumulator total; /* current total value calculated, promoted to a bignum if it outgrows a long */
+	IntList* pList; /* operands entered, in order */
+	Journal* pJournal; /* write-ahead journal of pushed operands, NULL for none */
+	Monitor* pMonitor; /* shared memory block the state is published to after every keystroke, NULL for none */
+} Session;
 
 void disableBuffer();
 void enableBuffer();
-void constructKeyboard( char *** ppcKeyBoardArray, int randInt );
-void displayCalculator( char** ppcKeyBoardArray, int currNum, int currTotal );
-void freeKeyboard ( char** ppcKeyBoardArray );
-int userInterfaceManager( char** ppcKeyBoardArray, int* piCurrCursorPos, char* piInputCh, int* piCurrNum, int* piDigitCount, int* piCurrTotal, LinkedList* pList );
-void writeDataToFile( LinkedList* pList, FILE* pInFile, int currTotal, FunPtr fpFreeDataFunc);
+void constructKeyboard( Keyboard* pKeyboard, int layout );
+void initSession( Session* pSession, int layout );
+void freeSession( Session* pSession );
+void displayCalculator( const Session* pSession );
+int userInterfaceManager( Session* pSession, char* pcInputCh );
+int writeDataToFile( IntList* pList, FILE* pInFile, const Accumulator* pCurrTotal );
+void waitForKeystrokes( int fd, Journal* pJournal );
+size_t readKeystrokes( int fd, char* pcKeys, size_t capacity );
+int applyKeystrokes( Session* pSession, char* pcKeys, size_t count, Stats* pStats );
+int replayKeystrokes( FILE* pKeyFile, Session* pSession, Stats* pStats );
 
 
 #endif
\ No newline at end of file
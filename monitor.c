@@ -0,0 +1,279 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "monitor.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+/* the fields between sequence and the end of the block are what the seqlock protects */
+#define MONITOR_FIELD_COUNT ( ( sizeof( MonitorBlock ) - offsetof( MonitorBlock, pid ) ) / sizeof( long ) )
+
+
+/**
+ * @brief  writes the POSIX shared memory object name for a monitor name, adding the leading '/' if it is missing.
+ * @param  pcName: name given on the command line, i.e. "till3" (Type: Char array).
+ * @param  pcObjectName: receives the object name, at most MONITOR_NAME_SIZE characters (Type: Char array).
+ * @retval None
+ */
+void monitorObjectName( const char* pcName, char* pcObjectName ) {
+    size_t offset = ( pcName[0] == '/' ) ? 0 : 1;
+
+    pcObjectName[0] = '/';
+    strncpy( pcObjectName + offset, pcName, MONITOR_NAME_SIZE - offset - 1 );
+    pcObjectName[MONITOR_NAME_SIZE - 1] = '\0';
+}
+
+
+/**
+ * @brief  checks whether the calculator that published to a block is still running.
+ * @note   a process that exists but belongs to another user counts as running.
+ * @param  pid: pid recorded in the block (Type: Long).
+ * @retval returns TRUE if the process exists, FALSE if it has exited.
+ */
+int monitorWriterAlive( long pid ) {
+    return pid > 0 && ( kill( ( pid_t ) pid, 0 ) == 0 || errno != ESRCH );
+}
+
+
+/**
+ * @brief  removes a block left behind by a calculator that exited without closing its monitor.
+ * @note   only a complete calculator block whose recorded pid has exited is removed; a block still being set up, a block 
+ * * of a running calculator or anything else under the name is left alone. Calculators starting together may both find 
+ * * the same stale block, so the unlink is done holding a flock on it and only if the name still refers to that block: 
+ * * the one that loses the race must not unlink the block the winner has just created.
+ * @param  pcObjectName: shared memory object name (Type: Char array).
+ * @retval returns TRUE if the stale block is gone and creating the name can be retried, FALSE otherwise.
+ */
+static int removeStaleMonitor( const char* pcObjectName ) {
+    const MonitorBlock* pBlock;
+    struct stat info, current;
+    void* pMapping;
+    int fd, currentFd, stale, removed = FALSE;
+
+    if ( ( fd = shm_open( pcObjectName, O_RDONLY, 0 ) ) < 0 ) {
+        return errno == ENOENT; /* already gone, creating it can be retried */
+    }
+    if ( fstat( fd, &info ) != 0 || info.st_size < ( off_t ) sizeof( MonitorBlock )
+         || ( pMapping = mmap( NULL, sizeof( MonitorBlock ), PROT_READ, MAP_SHARED, fd, 0 ) ) == MAP_FAILED ) {
+        close( fd );
+        return FALSE;
+    }
+
+    pBlock = ( const MonitorBlock* ) pMapping;
+    stale = __atomic_load_n( &pBlock->magic, __ATOMIC_ACQUIRE ) == MONITOR_MAGIC && !monitorWriterAlive( pBlock->pid );
+    munmap( pMapping, sizeof( MonitorBlock ) );
+
+    if ( stale && flock( fd, LOCK_EX ) == 0 ) {
+        if ( ( currentFd = shm_open( pcObjectName, O_RDONLY, 0 ) ) < 0 ) {
+            removed = ( errno == ENOENT ); /* another calculator removed it first */
+        }
+        else {
+            if ( fstat( currentFd, &current ) == 0 ) {
+                /* a different block under the name means another calculator replaced it first, O_EXCL then settles it */
+                removed = ( current.st_ino != info.st_ino || current.st_dev != info.st_dev || shm_unlink( pcObjectName ) == 0 );
+            }
+            close( currentFd );
+        }
+    }
+
+    close( fd ); /* releases the flock */
+    return removed;
+}
+
+
+/**
+ * @brief  creates the shared memory block a session's live state is published to.
+ * @note   the name is created exclusively, so two calculators never publish to the same block. A block left by a 
+ * * calculator that has since exited is replaced. Monitors such as calcmon map it read-only.
+ * @param  pcName: shared memory name (Type: Char array).
+ * @retval returns the monitor, NULL if the shared memory could not be created or a running calculator is using the name.
+ */
+Monitor* openMonitor( const char* pcName ) {
+    Monitor* pMonitor = ( Monitor* ) malloc( sizeof( Monitor ) );
+    void* pMapping;
+    int fd;
+
+    if ( pMonitor == NULL ) {
+        return NULL;
+    }
+
+    monitorObjectName( pcName, pMonitor->acName );
+    pMonitor->keystrokes = 0;
+
+    fd = shm_open( pMonitor->acName, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if ( fd < 0 && errno == EEXIST && removeStaleMonitor( pMonitor->acName ) ) {
+        fd = shm_open( pMonitor->acName, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    }
+    if ( fd < 0 ) {
+        free( pMonitor );
+        return NULL;
+    }
+
+    if ( ftruncate( fd, sizeof( MonitorBlock ) ) != 0
+         || ( pMapping = mmap( NULL, sizeof( MonitorBlock ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) ) == MAP_FAILED ) {
+        close( fd );
+        shm_unlink( pMonitor->acName );
+        free( pMonitor );
+        return NULL;
+    }
+    close( fd );
+
+    pMonitor->pBlock = ( MonitorBlock* ) pMapping;
+    memset( pMonitor->pBlock, 0, sizeof( MonitorBlock ) );
+    pMonitor->pBlock->pid = ( long ) getpid();
+    pMonitor->pBlock->version = MONITOR_VERSION;
+    __atomic_store_n( &pMonitor->pBlock->magic, MONITOR_MAGIC, __ATOMIC_RELEASE );
+
+    return pMonitor;
+}
+
+
+/**
+ * @brief  publishes a session's state, i.e. after a keystroke.
+ * @note   a seqlock: the sequence is made odd, the fields are stored and the sequence is made even again, so a reader 
+ * * that sees the same even sequence before and after copying has a consistent snapshot. Only plain stores to mapped 
+ * * memory, no system calls and no locks, so it costs the calculator a few nanoseconds per keystroke. A total that has 
+ * * outgrown a long is flagged rather than formatted.
+ * @param  pMonitor: monitor to publish to (Type: Pointer to a type defined struct called "Monitor").
+ * @param  keystrokes: keystrokes applied since the last publish (Type: Integer).
+ * @param  layout: keyboard layout (Type: Integer).
+ * @param  cursorKey: key the cursor is under (Type: Integer).
+ * @param  currNum: number on display (Type: Integer).
+ * @param  operands: operands in the history (Type: Long).
+ * @param  pTotal: current total (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval None
+ */
+void publishMonitor( Monitor* pMonitor, int keystrokes, int layout, int cursorKey, int currNum, long operands, const Accumulator* pTotal ) {
+    MonitorBlock* pBlock = pMonitor->pBlock;
+    unsigned long sequence = pBlock->sequence; /* only this process writes it */
+
+    __atomic_store_n( &pBlock->sequence, sequence + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    pMonitor->keystrokes += ( unsigned long ) keystrokes;
+    __atomic_store_n( &pBlock->layout, ( long ) layout, __ATOMIC_RELAXED );
+    __atomic_store_n( &pBlock->cursorKey, ( long ) cursorKey, __ATOMIC_RELAXED );
+    __atomic_store_n( &pBlock->currNum, ( long ) currNum, __ATOMIC_RELAXED );
+    __atomic_store_n( &pBlock->operands, operands, __ATOMIC_RELAXED );
+    __atomic_store_n( &pBlock->totalIsBig, ( long ) pTotal->isBig, __ATOMIC_RELAXED );
+    if ( !pTotal->isBig ) {
+        __atomic_store_n( &pBlock->total, pTotal->small, __ATOMIC_RELAXED );
+    }
+    __atomic_store_n( &pBlock->keystrokes, pMonitor->keystrokes, __ATOMIC_RELAXED );
+
+    __atomic_store_n( &pBlock->sequence, sequence + 2, __ATOMIC_RELEASE );
+}
+
+
+/**
+ * @brief  marks the session finished and removes the shared memory name; monitors still attached keep the last state.
+ * @param  pMonitor: monitor to close, may be NULL (Type: Pointer to a type defined struct called "Monitor").
+ * @retval None
+ */
+void closeMonitor( Monitor* pMonitor ) {
+    if ( pMonitor == NULL ) {
+        return;
+    }
+
+    __atomic_store_n( &pMonitor->pBlock->finished, ( long ) TRUE, __ATOMIC_RELEASE );
+    munmap( pMonitor->pBlock, sizeof( MonitorBlock ) );
+    shm_unlink( pMonitor->acName );
+    free( pMonitor );
+}
+
+
+/**
+ * @brief  maps a calculator's shared memory block read-only.
+ * @param  pcName: shared memory name the calculator was given with --shm (Type: Char array).
+ * @retval returns the block, NULL if there is no such block or it is not a calculator's.
+ */
+const MonitorBlock* attachMonitor( const char* pcName ) {
+    char acObjectName[MONITOR_NAME_SIZE];
+    const MonitorBlock* pBlock;
+    void* pMapping;
+    int fd;
+
+    monitorObjectName( pcName, acObjectName );
+
+    if ( ( fd = shm_open( acObjectName, O_RDONLY, 0 ) ) < 0 ) {
+        return NULL;
+    }
+    pMapping = mmap( NULL, sizeof( MonitorBlock ), PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if ( pMapping == MAP_FAILED ) {
+        return NULL;
+    }
+
+    pBlock = ( const MonitorBlock* ) pMapping;
+    if ( __atomic_load_n( &pBlock->magic, __ATOMIC_ACQUIRE ) != MONITOR_MAGIC || pBlock->version != MONITOR_VERSION ) {
+        munmap( pMapping, sizeof( MonitorBlock ) );
+        return NULL;
+    }
+
+    return pBlock;
+}
+
+
+/**
+ * @brief  copies a consistent snapshot of a block.
+ * @note   retries while the calculator is mid-update (odd sequence) or updated the block during the copy, probing the 
+ * * calculator every MONITOR_READ_PROBE_INTERVAL tries: one killed mid-update leaves the sequence odd for good. Gives up 
+ * * after MONITOR_READ_RETRIES tries, i.e. while a calculator is stopped mid-update, so the caller can wait and call again.
+ * @param  pBlock: block mapped with attachMonitor (Type: Pointer to a type defined struct called "MonitorBlock").
+ * @param  pCopy: receives the snapshot, undefined unless MONITOR_READ_OK is returned (Type: Pointer to a type defined struct called "MonitorBlock").
+ * @retval returns MONITOR_READ_OK, MONITOR_READ_BUSY if no consistent copy was made, or MONITOR_READ_GONE if the 
+ * * calculator exited mid-update.
+ */
+int readMonitor( const MonitorBlock* pBlock, MonitorBlock* pCopy ) {
+    const long* plFrom = &pBlock->pid;
+    long* plTo = &pCopy->pid;
+    unsigned long before, after;
+    size_t field;
+    long attempt;
+
+    for ( attempt = 1 ; attempt <= MONITOR_READ_RETRIES ; attempt++ ) {
+        before = __atomic_load_n( &pBlock->sequence, __ATOMIC_ACQUIRE );
+
+        if ( ( before & 1 ) == 0 ) {
+            for ( field = 0 ; field < MONITOR_FIELD_COUNT ; field++ ) {
+                plTo[field] = __atomic_load_n( &plFrom[field], __ATOMIC_RELAXED );
+            }
+            __atomic_thread_fence( __ATOMIC_ACQUIRE );
+            after = __atomic_load_n( &pBlock->sequence, __ATOMIC_RELAXED );
+
+            if ( before == after ) {
+                pCopy->magic = pBlock->magic;
+                pCopy->version = pBlock->version;
+                pCopy->sequence = before;
+                return MONITOR_READ_OK;
+            }
+        }
+
+        if ( attempt % MONITOR_READ_PROBE_INTERVAL == 0 && !monitorWriterAlive( pBlock->pid ) ) { /* pid never changes once set up */
+            return MONITOR_READ_GONE;
+        }
+
+        sched_yield();
+    }
+
+    return MONITOR_READ_BUSY;
+}
+
+
+/**
+ * @brief  unmaps a block mapped with attachMonitor.
+ * @retval None
+ */
+void detachMonitor( const MonitorBlock* pBlock ) {
+    munmap( ( void* ) pBlock, sizeof( MonitorBlock ) );
+}
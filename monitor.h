@@ -0,0 +1,50 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include "accumulator.h"
+
+#define MONITOR_MAGIC 0x4E4F4D43UL /* "CMON" */
+#define MONITOR_VERSION 1
+#define MONITOR_NAME_SIZE 256
+#define MONITOR_DEFAULT_INTERVAL_MS 1000L
+#define MONITOR_READ_RETRIES 4096L /* tries readMonitor makes before reporting MONITOR_READ_BUSY */
+#define MONITOR_READ_PROBE_INTERVAL 64L /* tries between checks that the calculator is still running */
+
+#define MONITOR_READ_OK 0 /* consistent snapshot copied */
+#define MONITOR_READ_BUSY 1 /* the calculator stayed mid-update, try again later */
+#define MONITOR_READ_GONE 2 /* the calculator exited mid-update, the block will not change again */
+
+typedef struct MonitorBlock
+{
+	unsigned long magic; /* MONITOR_MAGIC once the block is set up */
+	unsigned long version; /* MONITOR_VERSION */
+	unsigned long sequence; /* seqlock: odd while the calculator is updating the fields below */
+	long pid; /* calculator process */
+	long layout; /* keyboard layout */
+	long cursorKey; /* key the cursor is under */
+	long currNum; /* number on display */
+	long operands; /* operands in the history */
+	long total; /* total while it fits a long */
+	long totalIsBig; /* TRUE once the total has outgrown a long, total is then stale */
+	unsigned long keystrokes; /* keystrokes applied so far */
+	long finished; /* TRUE once the session has ended */
+} MonitorBlock;
+
+typedef struct Monitor
+{
+	MonitorBlock* pBlock; /* shared memory mapping */
+	char acName[MONITOR_NAME_SIZE]; /* shared memory object name, unlinked when the monitor is closed */
+	unsigned long keystrokes; /* private copy of the counter, so updating it never reads shared memory */
+} Monitor;
+
+
+int monitorWriterAlive( long pid );
+Monitor* openMonitor( const char* pcName );
+void publishMonitor( Monitor* pMonitor, int keystrokes, int layout, int cursorKey, int currNum, long operands, const Accumulator* pTotal );
+void closeMonitor( Monitor* pMonitor );
+const MonitorBlock* attachMonitor( const char* pcName );
+int readMonitor( const MonitorBlock* pBlock, MonitorBlock* pCopy );
+void detachMonitor( const MonitorBlock* pBlock );
+void monitorObjectName( const char* pcName, char* pcObjectName );
+
+#endif
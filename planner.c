@@ -0,0 +1,138 @@
+#include <string.h>
+#include "planner.h"
+
+/* bytes that move the cursor, tried in this order so ties between equally short paths are broken the same way every time */
+static const char CURSOR_MOVES[4] = { 'w', 'a', 's', 'd' };
+
+
+/**
+ * @brief  finds the shortest cursor path between every pair of keys of a layout.
+ * @note   a breadth first search from each key over the moves of the layout's transition table, so edges, and any key a 
+ * * move cannot leave, are taken from the same table userInterfaceManager follows. Called once per layout when its 
+ * * transitions are built; afterwards planning a glyph is a table lookup.
+ * @param  paTransitions: the layout's transition table, [key][input byte] (Type: Pointer to KeyTransition arrays).
+ * @param  paPaths: receives the paths, [from key][to key] (Type: Pointer to KeyPath arrays).
+ * @retval None
+ */
+void buildKeyPaths( const KeyTransition ( *paTransitions )[256], KeyPath ( *paPaths )[KEY_COUNT] ) {
+    int aiQueue[KEY_COUNT]; /* keys in the order they were reached */
+    int aiParent[KEY_COUNT]; /* key each key was first reached from, -1 if not yet reached */
+    char acVia[KEY_COUNT]; /* move that first reached each key */
+    int source, target, key, next, move, head, tail, length;
+
+    for ( source = 0 ; source < KEY_COUNT ; source++ ) {
+        for ( key = 0 ; key < KEY_COUNT ; key++ ) {
+            aiParent[key] = -1;
+        }
+        aiParent[source] = source;
+        aiQueue[0] = source;
+
+        for ( head = 0, tail = 1 ; head < tail ; head++ ) {
+            key = aiQueue[head];
+
+            for ( move = 0 ; move < 4 ; move++ ) {
+                next = paTransitions[key][( unsigned char ) CURSOR_MOVES[move]].next;
+
+                if ( aiParent[next] < 0 ) {
+                    aiParent[next] = key;
+                    acVia[next] = CURSOR_MOVES[move];
+                    aiQueue[tail++] = next;
+                }
+            }
+        }
+
+        /* walk each path back from its target, filling the moves in from the end */
+        for ( target = 0 ; target < KEY_COUNT ; target++ ) {
+            if ( aiParent[target] < 0 ) {
+                paPaths[source][target].length = KEY_PATH_UNREACHABLE;
+                continue;
+            }
+
+            for ( length = 0, key = target ; key != source ; key = aiParent[key] ) {
+                length++;
+            }
+            paPaths[source][target].length = ( unsigned char ) length;
+
+            for ( key = target ; key != source ; key = aiParent[key] ) {
+                paPaths[source][target].acMoves[--length] = acVia[key];
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief  returns the key a glyph is on.
+ * @param  pKeyboard: calculator keyboard (Type: Pointer to a type defined struct called "Keyboard").
+ * @param  glyph: glyph to look for, i.e. '7', '+' or '=' (Type: Char).
+ * @retval returns the key index, -1 if the glyph is not on the keyboard (blank keys are never matched).
+ */
+int findGlyphKey( const Keyboard* pKeyboard, char glyph ) {
+    int key;
+
+    for ( key = 0 ; key < KEY_COUNT && glyph != ' ' ; key++ ) {
+        if ( pKeyboard->acCells[KEY_GLYPH_CELL( key )] == glyph ) {
+            return key;
+        }
+    }
+
+    return -1;
+}
+
+
+/**
+ * @brief  writes the keystrokes that move the cursor under a glyph along a shortest path and confirm it.
+ * @note   the path is looked up in the layout's precomputed table. Nothing is written if the glyph is not on the keyboard.
+ * @param  pKeyboard: calculator keyboard (Type: Pointer to a type defined struct called "Keyboard").
+ * @param  piCursorKey: key the cursor is under, updated to the glyph's key (Type: Pointer to Integer).
+ * @param  glyph: glyph to confirm, i.e. '7', '+' or '=' (Type: Char).
+ * @param  pcKeys: receives at most PLAN_MAX_KEYS_PER_GLYPH keystrokes (Type: Char array).
+ * @retval returns the amount of keystrokes written, 0 if the glyph cannot be reached.
+ */
+size_t keysForGlyph( const Keyboard* pKeyboard, int* piCursorKey, char glyph, char* pcKeys ) {
+    const KeyPath* pPath;
+    int target = findGlyphKey( pKeyboard, glyph );
+
+    if ( target < 0 ) {
+        return 0;
+    }
+
+    pPath = &pKeyboard->paPaths[*piCursorKey][target];
+    if ( pPath->length == KEY_PATH_UNREACHABLE ) {
+        return 0;
+    }
+
+    memcpy( pcKeys, pPath->acMoves, pPath->length );
+    pcKeys[pPath->length] = 'e';
+    *piCursorKey = target;
+
+    return ( size_t ) pPath->length + 1;
+}
+
+
+/**
+ * @brief  expands a typed expression, i.e. "123+45=", into the fewest keystrokes that enter it.
+ * @note   every glyph is reached along its shortest path from where the previous one left the cursor, then confirmed. 
+ * * Spaces in the expression are skipped.
+ * @param  pKeyboard: calculator keyboard (Type: Pointer to a type defined struct called "Keyboard").
+ * @param  piCursorKey: key the cursor starts under, updated to where it ends (Type: Pointer to Integer).
+ * @param  pcText: glyphs to enter (Type: Char array).
+ * @param  pcKeys: receives up to strlen( pcText ) * PLAN_MAX_KEYS_PER_GLYPH keystrokes (Type: Char array).
+ * @retval returns the amount of keystrokes written, -1 if a glyph is not on the keyboard.
+ */
+long planKeystrokes( const Keyboard* pKeyboard, int* piCursorKey, const char* pcText, char* pcKeys ) {
+    size_t count = 0, keys;
+
+    for ( ; *pcText != '\0' ; pcText++ ) {
+        if ( *pcText == ' ' ) {
+            continue;
+        }
+
+        if ( ( keys = keysForGlyph( pKeyboard, piCursorKey, *pcText, pcKeys + count ) ) == 0 ) {
+            return -1;
+        }
+        count += keys;
+    }
+
+    return ( long ) count;
+}
@@ -0,0 +1,14 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stddef.h>
+#include "module.h"
+
+#define PLAN_MAX_KEYS_PER_GLYPH ( KEY_PATH_MAX_MOVES + 1 ) /* cursor moves and the confirming 'e' */
+
+void buildKeyPaths( const KeyTransition ( *paTransitions )[256], KeyPath ( *paPaths )[KEY_COUNT] );
+int findGlyphKey( const Keyboard* pKeyboard, char glyph );
+size_t keysForGlyph( const Keyboard* pKeyboard, int* piCursorKey, char glyph, char* pcKeys );
+long planKeystrokes( const Keyboard* pKeyboard, int* piCursorKey, const char* pcText, char* pcKeys );
+
+#endif
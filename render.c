@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "render.h"
+
+/* screen coordinates (1-based) of the parts of the frame drawn by displayCalculator */
+#define NUMBER_ROW 2
+#define NUMBER_COL 2
+#define KEYBOARD_TOP_ROW 5
+#define TOTAL_ROW ( KEYBOARD_TOP_ROW + KEYBOARD_ROWS + 1 )
+#define TOTAL_COL 17
+
+#define FRAME_ENTER "\033[?1049h\033[?25l\033[H\033[2J" /* alternate screen, hide cursor, clear */
+#define FRAME_LEAVE "\033[?25h\033[?1049l" /* show cursor, main screen */
+
+
+/**
+ * @brief  appends formatted text to the frame being assembled.
+ * @note   frames are far smaller than RENDER_BUFFER_SIZE, text that would not fit is dropped rather than overflowing.
+ * @param  pRenderer: renderer holding the frame buffer (Type: Pointer to a type defined struct called "Renderer").
+ * @param  pcText: text to append (Type: Char array).
+ * @param  length: amount of characters in pcText (Type: size_t).
+ * @retval None
+ */
+static void appendFrame( Renderer* pRenderer, const char* pcText, size_t length ) {
+    if ( pRenderer->length + length <= RENDER_BUFFER_SIZE ) {
+        memcpy( pRenderer->acBuffer + pRenderer->length, pcText, length );
+        pRenderer->length += length;
+    }
+}
+
+
+/**
+ * @brief  writes every byte of a buffer to a file descriptor.
+ * @note   retries on short writes and interrupted system calls. Gives up if a non-blocking descriptor would block.
+ * @param  fd: file descriptor to write to (Type: Integer).
+ * @param  pcData: bytes to write (Type: Char array).
+ * @param  length: amount of bytes to write (Type: size_t).
+ * @retval returns TRUE if everything was written, FALSE on error.
+ */
+static int writeAll( int fd, const char* pcData, size_t length ) {
+    ssize_t written;
+
+    while ( length > 0 ) {
+        written = write( fd, pcData, length );
+
+        if ( written < 0 ) {
+            if ( errno != EINTR ) {
+                return FALSE;
+            }
+        }
+        else {
+            pcData += written;
+            length -= ( size_t ) written;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  formats the total into the renderer's scratch buffer.
+ * @note   both total buffers grow together so they can be swapped once the total has been drawn.
+ * @param  pRenderer: renderer holding the buffers (Type: Pointer to a type defined struct called "Renderer").
+ * @param  pCurrTotal: total to format (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns the amount of characters formatted.
+ */
+static size_t formatTotal( Renderer* pRenderer, const Accumulator* pCurrTotal ) {
+    size_t length = accumulatorLength( pCurrTotal );
+
+    if ( length > pRenderer->totalCapacity ) {
+        pRenderer->totalCapacity = length * 2;
+        pRenderer->pcTotalText = ( char* ) realloc( pRenderer->pcTotalText, pRenderer->totalCapacity );
+        pRenderer->pcLastTotal = ( char* ) realloc( pRenderer->pcLastTotal, pRenderer->totalCapacity );
+    }
+
+    return formatAccumulator( pCurrTotal, pRenderer->pcTotalText );
+}
+
+
+/**
+ * @brief  makes the total just formatted the last drawn total.
+ * @retval None
+ */
+static void keepTotal( Renderer* pRenderer, size_t length ) {
+    char* pcTemp = pRenderer->pcLastTotal;
+
+    pRenderer->pcLastTotal = pRenderer->pcTotalText;
+    pRenderer->pcTotalText = pcTemp;
+    pRenderer->lastTotalLength = length;
+}
+
+
+/**
+ * @brief  creates a renderer that draws the calculator to a terminal.
+ * @note   nothing is written until the first call to renderCalculator, which switches to the alternate screen buffer.
+ * @param  fd: file descriptor of the terminal to draw to (Type: Integer).
+ * @retval Returns Renderer Struct.
+ */
+Renderer* createRenderer( int fd ) {
+    Renderer* pRenderer = ( Renderer* ) malloc( sizeof( Renderer ) );
+    pRenderer->fd = fd;
+    pRenderer->hasFrame = FALSE;
+    pRenderer->length = 0;
+    pRenderer->totalCapacity = 32;
+    pRenderer->pcLastTotal = ( char* ) malloc( pRenderer->totalCapacity );
+    pRenderer->pcTotalText = ( char* ) malloc( pRenderer->totalCapacity );
+    pRenderer->lastTotalLength = 0;
+
+    return pRenderer;
+}
+
+
+/**
+ * @brief  draws the calculator, writing only what changed since the previous frame.
+ * @note   the first frame enters the alternate screen buffer and draws the full layout of displayCalculator. Later frames 
+ * * move the terminal cursor with ANSI escapes to each changed keyboard cell (usually just the old and new '^'), the 
+ * * display number and the total. The whole frame 
+ * * is sent with a single write. If the frame cannot be written in full (i.e. a client socket that is not draining), the 
+ * * next frame is drawn from scratch, since the terminal no longer matches what was last drawn.
+ * @param  pRenderer: renderer holding the previous frame (Type: Pointer to a type defined struct called "Renderer").
+ * @param  pSession: calculator session to draw; its cursor is drawn as KEYBOARD_CURSOR below its key (Type: Pointer to a type defined struct called "Session").
+ * @retval None
+ */
+void renderCalculator( Renderer* pRenderer, const Session* pSession ) {
+    char acText[64]; /* scratch space for a single escape sequence */
+    int row, col;
+    const Keyboard* pKeyboard = &pSession->keyboard;
+    int currNum = pSession->currNum;
+    int cursorCell = KEY_CURSOR_CELL( pSession->cursorKey );
+    char cell;
+    size_t totalLength;
+
+    pRenderer->length = 0;
+    totalLength = formatTotal( pRenderer, &pSession->total );
+
+    if ( !pRenderer->hasFrame ) { /* first frame, draw everything */
+        appendFrame( pRenderer, FRAME_ENTER, strlen( FRAME_ENTER ) );
+        sprintf( acText, "---------\n|%7d|\n---------\n\n", currNum );
+        appendFrame( pRenderer, acText, strlen( acText ) );
+
+        for ( row = 0 ; row < KEYBOARD_ROWS ; row++ ) {
+            for ( col = 0 ; col < KEYBOARD_COLS ; col++ ) {
+                cell = ( row * KEYBOARD_COLS + col == cursorCell ) ? KEYBOARD_CURSOR : pKeyboard->acCells[row * KEYBOARD_COLS + col];
+                pRenderer->acLastCells[row * KEYBOARD_COLS + col] = cell;
+                appendFrame( pRenderer, &cell, 1 );
+                appendFrame( pRenderer, " ", 1 );
+            }
+            appendFrame( pRenderer, "\n", 1 );
+        }
+
+        appendFrame( pRenderer, "\ncurrent total : ", 17 );
+        appendFrame( pRenderer, pRenderer->pcTotalText, totalLength );
+        appendFrame( pRenderer, "\n", 1 );
+
+        pRenderer->lastNum = currNum;
+        keepTotal( pRenderer, totalLength );
+        pRenderer->hasFrame = TRUE;
+    }
+
+    else { /* later frames, only redraw cells that changed */
+        for ( row = 0 ; row < KEYBOARD_ROWS ; row++ ) {
+            for ( col = 0 ; col < KEYBOARD_COLS ; col++ ) {
+                cell = ( row * KEYBOARD_COLS + col == cursorCell ) ? KEYBOARD_CURSOR : pKeyboard->acCells[row * KEYBOARD_COLS + col];
+
+                if ( cell != pRenderer->acLastCells[row * KEYBOARD_COLS + col] ) {
+                    sprintf( acText, "\033[%d;%dH%c", KEYBOARD_TOP_ROW + row, 1 + col * 2, cell );
+                    appendFrame( pRenderer, acText, strlen( acText ) );
+                    pRenderer->acLastCells[row * KEYBOARD_COLS + col] = cell;
+                }
+            }
+        }
+
+        if ( currNum != pRenderer->lastNum ) {
+            sprintf( acText, "\033[%d;%dH%7d", NUMBER_ROW, NUMBER_COL, currNum );
+            appendFrame( pRenderer, acText, strlen( acText ) );
+            pRenderer->lastNum = currNum;
+        }
+
+        if ( totalLength != pRenderer->lastTotalLength || memcmp( pRenderer->pcTotalText, pRenderer->pcLastTotal, totalLength ) != 0 ) {
+            sprintf( acText, "\033[%d;%dH", TOTAL_ROW, TOTAL_COL );
+            appendFrame( pRenderer, acText, strlen( acText ) );
+            appendFrame( pRenderer, pRenderer->pcTotalText, totalLength );
+            appendFrame( pRenderer, "\033[K", 3 );
+            keepTotal( pRenderer, totalLength );
+        }
+    }
+
+    if ( pRenderer->length > 0 && !writeAll( pRenderer->fd, pRenderer->acBuffer, pRenderer->length ) ) {
+        pRenderer->hasFrame = FALSE;
+    }
+}
+
+
+/**
+ * @brief  frees the renderer and restores the terminal.
+ * @note   leaves the alternate screen buffer and shows the terminal cursor again if a frame was ever drawn.
+ * @param  pRenderer: renderer to free (Type: Pointer to a type defined struct called "Renderer").
+ * @retval None
+ */
+void freeRenderer( Renderer* pRenderer ) {
+    if ( pRenderer != NULL ) {
+        if ( pRenderer->hasFrame ) {
+            writeAll( pRenderer->fd, FRAME_LEAVE, strlen( FRAME_LEAVE ) );
+        }
+        free( pRenderer->pcLastTotal );
+        free( pRenderer->pcTotalText );
+        free( pRenderer );
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "module.h"
+
+#define RENDER_BUFFER_SIZE 4096
+
+typedef struct Renderer
+{
+	int fd; /* file descriptor frames are written to */
+	int hasFrame; /* FALSE until the first full frame has been drawn */
+	char acLastCells[KEYBOARD_SIZE]; /* keyboard cells as last drawn */
+	int lastNum; /* display number as last drawn */
+	char* pcLastTotal; /* total as last drawn, in decimal */
+	size_t lastTotalLength; /* characters in pcLastTotal */
+	char* pcTotalText; /* scratch space the current total is formatted into */
+	size_t totalCapacity; /* bytes allocated for each of pcLastTotal and pcTotalText */
+	size_t length; /* bytes queued in acBuffer for the current frame */
+	char acBuffer[RENDER_BUFFER_SIZE]; /* frame being assembled, sent with a single write */
+} Renderer;
+
+
+Renderer* createRenderer( int fd );
+void renderCalculator( Renderer* pRenderer, const Session* pSession );
+void freeRenderer( Renderer* pRenderer );
+
+#endif
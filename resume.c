@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "resume.h"
+#include "binfmt.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+
+/**
+ * @brief  rebuilds the operands of a text output line, "a + b + ... + z", into a list.
+ * @note   the line lists the operands last entered first, so it is scanned backwards from its end: each number is found 
+ * * by walking back over its digits, converted forwards, and collected oldest first into a chunk sized block that is 
+ * * appended with appendInts. Block sums are added to the total once per block.
+ * @retval returns the amount of operands, -1 if the text is not operands joined by " + ".
+ */
+static long scanOperands( const char* pcStart, const char* pcEnd, IntList* pList, Accumulator* pTotal ) {
+    int aiBlock[INT_LIST_CHUNK_CAPACITY];
+    const char* pcNumber; /* first character of the number being scanned, its sign included */
+    const char* pcDigit;
+    long value, blockSum = 0, count = 0;
+    int blockCount = 0;
+
+    while ( pcEnd > pcStart ) {
+        for ( pcNumber = pcEnd ; pcNumber > pcStart && pcNumber[-1] >= '0' && pcNumber[-1] <= '9' ; pcNumber-- ) {
+        }
+        if ( pcNumber == pcEnd || pcEnd - pcNumber > RESUME_MAX_DIGITS ) {
+            return -1;
+        }
+
+        for ( value = 0, pcDigit = pcNumber ; pcDigit < pcEnd ; pcDigit++ ) {
+            value = value * 10 + ( *pcDigit - '0' );
+        }
+        if ( pcNumber > pcStart && pcNumber[-1] == '-' ) {
+            value = -value;
+            pcNumber--;
+        }
+        if ( value > INT_MAX || value < INT_MIN ) {
+            return -1;
+        }
+
+        aiBlock[blockCount++] = ( int ) value;
+        blockSum += value;
+        count++;
+
+        if ( blockCount == INT_LIST_CHUNK_CAPACITY ) {
+            if ( !appendInts( pList, aiBlock, blockCount ) ) {
+                return -1;
+            }
+            addAccumulator( pTotal, blockSum );
+            blockCount = 0;
+            blockSum = 0;
+        }
+
+        /* the number is either the first on the line or follows a separator */
+        if ( pcNumber > pcStart ) {
+            if ( pcNumber - pcStart < RESUME_SEPARATOR_SIZE + 1 || memcmp( pcNumber - RESUME_SEPARATOR_SIZE, RESUME_SEPARATOR, RESUME_SEPARATOR_SIZE ) != 0 ) {
+                return -1;
+            }
+            pcNumber -= RESUME_SEPARATOR_SIZE;
+        }
+        pcEnd = pcNumber;
+    }
+
+    if ( !appendInts( pList, aiBlock, blockCount ) ) {
+        return -1;
+    }
+    addAccumulator( pTotal, blockSum );
+
+    return count;
+}
+
+
+/**
+ * @brief  rebuilds a session from the text writeDataToFile writes: "z + ... + b + a = total", or only the total when 
+ * * there were fewer than two operands.
+ * @note   the stated total must match the sum of the operands exactly.
+ * @retval returns the amount of operands, -1 if the text is not such a line.
+ */
+static long resumeText( const char* pcText, size_t length, IntList* pList, Accumulator* pTotal ) {
+    const char* pcEnd = pcText + length;
+    const char* pcEquals;
+    char* pcSum;
+    size_t sumLength;
+    long count;
+    int matches;
+
+    if ( length > 0 && pcEnd[-1] == '\n' ) {
+        pcEnd--;
+    }
+    if ( memchr( pcText, '\n', ( size_t ) ( pcEnd - pcText ) ) != NULL ) {
+        return -1; /* an output file holds exactly one line */
+    }
+
+    for ( pcEquals = pcEnd ; pcEquals > pcText && *( pcEquals - 1 ) != '=' ; pcEquals-- ) {
+    }
+
+    if ( pcEquals == pcText ) { /* no " = ": the line is a lone operand, or 0 for none */
+        if ( ( count = scanOperands( pcText, pcEnd, pList, pTotal ) ) != 1 ) {
+            return -1;
+        }
+        if ( accumulatorIsZero( pTotal ) ) {
+            removeLastInt( pList, NULL );
+            count = 0;
+        }
+        return count;
+    }
+
+    /* pcEquals is just after '=', the operands end before " = " */
+    if ( pcEquals - pcText < 3 || pcEquals[-2] != ' ' || pcEquals >= pcEnd || *pcEquals != ' ' ) {
+        return -1;
+    }
+    if ( ( count = scanOperands( pcText, pcEquals - 2, pList, pTotal ) ) < 2 ) {
+        return -1;
+    }
+
+    /* compare the stated total with the sum as text, so totals too large for a long compare as well */
+    pcSum = ( char* ) malloc( accumulatorLength( pTotal ) );
+    sumLength = formatAccumulator( pTotal, pcSum );
+    matches = ( sumLength == ( size_t ) ( pcEnd - pcEquals - 1 ) && memcmp( pcSum, pcEquals + 1, sumLength ) == 0 );
+    free( pcSum );
+
+    return matches ? count : -1;
+}
+
+
+/**
+ * @brief  restores the operands and total of an earlier session from its output file, so the session can carry on.
+ * @note   the file is mapped rather than read, and holds either the text line of writeDataToFile or a binary record of 
+ * * writeBinaryFile. Text is scanned with a dedicated integer scanner and appended a chunk at a time, so a history of 
+ * * millions of operands is back in milliseconds. A missing or empty file resumes nothing.
+ * @param  pcPath: output file of the earlier session (Type: Char array).
+ * @param  pList: empty list the operands are appended to, oldest first (Type: Pointer to a type defined struct called "IntList").
+ * @param  pTotal: accumulator initialised to 0 that receives the total (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns the amount of operands restored, -1 if the file could not be read or is not a calculator output, in 
+ * * which case pList and pTotal may hold part of it and the session should not carry on.
+ */
+long resumeSession( const char* pcPath, IntList* pList, Accumulator* pTotal ) {
+    struct stat info;
+    const char* pcData;
+    size_t length, consumed;
+    long count;
+    int fd;
+
+    if ( ( fd = open( pcPath, O_RDONLY ) ) < 0 ) {
+        return ( errno == ENOENT ) ? 0 : -1;
+    }
+
+    if ( fstat( fd, &info ) != 0 ) {
+        close( fd );
+        return -1;
+    }
+    if ( info.st_size == 0 ) {
+        close( fd );
+        return 0;
+    }
+
+    length = ( size_t ) info.st_size;
+    pcData = ( const char* ) mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if ( pcData == MAP_FAILED ) {
+        return -1;
+    }
+    posix_madvise( ( void* ) pcData, length, POSIX_MADV_WILLNEED );
+
+    if ( length >= BINFMT_MAGIC_SIZE && memcmp( pcData, BINFMT_MAGIC, BINFMT_MAGIC_SIZE ) == 0 ) {
+        count = ( readBinaryRecord( ( const unsigned char* ) pcData, length, &consumed, pList, pTotal ) == BINFMT_OK ) ? pList->size : -1;
+    }
+    else {
+        count = resumeText( pcData, length, pList, pTotal );
+    }
+
+    munmap( ( void* ) pcData, length );
+    return count;
+}
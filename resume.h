@@ -0,0 +1,13 @@
+#ifndef RESUME_H
+#define RESUME_H
+
+#include "intList.h"
+#include "accumulator.h"
+
+#define RESUME_SEPARATOR " + "
+#define RESUME_SEPARATOR_SIZE 3
+#define RESUME_MAX_DIGITS 10 /* an int has at most 10 decimal digits */
+
+long resumeSession( const char* pcPath, IntList* pList, Accumulator* pTotal );
+
+#endif
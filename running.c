@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "running.h"
+#include "serialize.h"
+
+#if defined( __SSE2__ ) && defined( __LP64__ )
+#include <emmintrin.h>
+#define RUNNING_SSE2 /* two 64-bit subtotals per vector; x86-64 always has SSE2 */
+#endif
+
+#define FALSE 0
+#define TRUE !FALSE
+
+#define RUNNING_PHASE_SCAN 0
+#define RUNNING_PHASE_FORMAT 1
+
+
+/**
+ * @brief  inclusive prefix sum of a range of operands into 64-bit subtotals, starting from 0.
+ * @note   with SSE2, four operands are loaded at a time and sign extended into two vectors of two subtotals. Within a 
+ * * vector the low lane is added to the high lane, then the running subtotal (broadcast to both lanes) is added and the 
+ * * new high lane becomes the running subtotal.
+ * @retval returns the sum of the range.
+ */
+static long scanRange( const int* piOperands, long* plSubtotals, long count ) {
+    long index = 0;
+    long running = 0;
+#ifdef RUNNING_SSE2
+    __m128i carry = _mm_setzero_si128();
+    __m128i values, sign, low, high;
+
+    for ( ; index + 4 <= count ; index += 4 ) {
+        values = _mm_loadu_si128( ( const __m128i* ) ( piOperands + index ) );
+        sign = _mm_srai_epi32( values, 31 );
+        low = _mm_unpacklo_epi32( values, sign ); /* operands 0 and 1 as 64-bit */
+        high = _mm_unpackhi_epi32( values, sign ); /* operands 2 and 3 */
+
+        low = _mm_add_epi64( low, _mm_slli_si128( low, 8 ) );
+        low = _mm_add_epi64( low, carry );
+        carry = _mm_shuffle_epi32( low, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+
+        high = _mm_add_epi64( high, _mm_slli_si128( high, 8 ) );
+        high = _mm_add_epi64( high, carry );
+        carry = _mm_shuffle_epi32( high, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+
+        _mm_storeu_si128( ( __m128i* ) ( plSubtotals + index ), low );
+        _mm_storeu_si128( ( __m128i* ) ( plSubtotals + index + 2 ), high );
+    }
+
+    if ( index > 0 ) {
+        running = plSubtotals[index - 1];
+    }
+#endif
+
+    for ( ; index < count ; index++ ) {
+        running += piOperands[index];
+        plSubtotals[index] = running;
+    }
+
+    return running;
+}
+
+
+/**
+ * @brief  formats "operand -> subtotal" lines for a task's range, adding the task's offset to each subtotal.
+ * @note   the text is sized exactly first so it is formatted into a single allocation.
+ * @retval None
+ */
+static void formatRange( RunningTask* pTask ) {
+    char acText[SERIALIZE_MAX_LONG_LENGTH];
+    size_t length = 0;
+    long index;
+    char* pcOut;
+
+    for ( index = pTask->start ; index < pTask->end ; index++ ) {
+        length += formatInt( pTask->piOperands[index], acText ) + formatLong( pTask->plSubtotals[index] + pTask->offset, acText ) + RUNNING_LINE_SEPARATOR_SIZE + 1;
+    }
+
+    pTask->pcOut = pcOut = ( char* ) malloc( length > 0 ? length : 1 );
+    pTask->outLength = length;
+
+    for ( index = pTask->start ; index < pTask->end ; index++ ) {
+        pcOut += formatInt( pTask->piOperands[index], pcOut );
+        memcpy( pcOut, RUNNING_LINE_SEPARATOR, RUNNING_LINE_SEPARATOR_SIZE );
+        pcOut += RUNNING_LINE_SEPARATOR_SIZE;
+        pcOut += formatLong( pTask->plSubtotals[index] + pTask->offset, pcOut );
+        *pcOut++ = '\n';
+    }
+}
+
+
+/**
+ * @brief  thread entry point, runs the task's current phase.
+ * @retval returns NULL.
+ */
+static void* runTask( void* pArg ) {
+    RunningTask* pTask = ( RunningTask* ) pArg;
+
+    if ( pTask->phase == RUNNING_PHASE_SCAN ) {
+        pTask->total = scanRange( pTask->piOperands + pTask->start, pTask->plSubtotals + pTask->start, pTask->end - pTask->start );
+    }
+    else {
+        formatRange( pTask );
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief  runs one phase of every task, the calling thread taking the first.
+ * @retval None
+ */
+static void runPhase( RunningTask* paTasks, int taskCount, int phase ) {
+    pthread_t aThreads[RUNNING_MAX_THREADS];
+    int aStarted[RUNNING_MAX_THREADS];
+    int task;
+
+    for ( task = 0 ; task < taskCount ; task++ ) {
+        paTasks[task].phase = phase;
+        aStarted[task] = ( task > 0 && pthread_create( &aThreads[task], NULL, &runTask, &paTasks[task] ) == 0 );
+    }
+    runTask( &paTasks[0] );
+    for ( task = 1 ; task < taskCount ; task++ ) {
+        if ( aStarted[task] ) {
+            pthread_join( aThreads[task], NULL );
+        }
+        else {
+            runTask( &paTasks[task] ); /* thread could not be started, run its task here */
+        }
+    }
+}
+
+
+/**
+ * @brief  writes every byte of a buffer to a file descriptor.
+ * @retval returns TRUE if everything was written.
+ */
+static int writeAll( int fd, const char* pcData, size_t length ) {
+    ssize_t written;
+
+    while ( length > 0 ) {
+        written = write( fd, pcData, length );
+
+        if ( written < 0 ) {
+            if ( errno != EINTR ) {
+                return FALSE;
+            }
+        }
+        else {
+            pcData += written;
+            length -= ( size_t ) written;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  writes the history one operand per line with the subtotal after it, "operand -> subtotal", in the order entered.
+ * @note   the operands are copied out of the list into one array and prefix summed into 64-bit subtotals (SSE2 on x86-64). 
+ * * Long histories are split between threads: each scans its range from 0, the range totals are summed into per-range 
+ * * offsets, then each thread formats its lines with its offset added, and the ranges are written in order. Histories 
+ * * long enough for the subtotals to leave a long (over 2^32 operands), or that have spilled to disk, are summed with an 
+ * * Accumulator instead, one line at a time. The last subtotal is checked against the session's total. An empty history 
+ * * is written as its total alone, "0".
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
+ * @param  pOutFile: output file (Type: Pointer to the type 'FILE').
+ * @param  pCurrTotal: total of the operands (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  threadCount: threads to use, the amount of online processors if 0 or less (Type: Integer).
+ * @retval returns TRUE if everything was written and the last subtotal matches pCurrTotal.
+ */
+int writeRunningTotals( IntList* pList, FILE* pOutFile, const Accumulator* pCurrTotal, int threadCount ) {
+    RunningTask aTasks[RUNNING_MAX_THREADS];
+    const IntListChunk* pChunk;
+    IntListIterator iter;
+    Accumulator subtotal;
+    int* piOperands;
+    long* plSubtotals;
+    long count = pList->size, offset = 0, copied = 0;
+    char* pcText;
+    size_t length;
+    int task, value, ok = TRUE;
+
+    /* nothing was entered, write the total alone, as the text format does */
+    if ( count == 0 ) {
+        printAccumulator( pOutFile, pCurrTotal );
+        return fputc( '\n', pOutFile ) != EOF;
+    }
+
+    /* subtotals could overflow a long, or the history has spilled to disk and is not to be brought back into memory at once */
+    if ( count > LONG_MAX / ( ( long ) INT_MAX + 1 ) || pList->spilledChunks > 0 ) {
+        initAccumulator( &subtotal );
+        pcText = ( char* ) malloc( SERIALIZE_MAX_INT_LENGTH + RUNNING_LINE_SEPARATOR_SIZE );
+
+        startIntListIterator( pList, &iter );
+        while ( ok && nextInt( &iter, &value ) ) {
+            addAccumulator( &subtotal, value );
+            length = formatInt( value, pcText );
+            fwrite( pcText, 1, length, pOutFile );
+            fputs( RUNNING_LINE_SEPARATOR, pOutFile );
+            printAccumulator( pOutFile, &subtotal );
+            ok = ( fputc( '\n', pOutFile ) != EOF );
+        }
+
+        ok = ok && !iter.failed && compareAccumulator( &subtotal, pCurrTotal ) == 0;
+        free( pcText );
+        freeAccumulator( &subtotal );
+        return ok;
+    }
+
+    if ( threadCount <= 0 ) {
+        threadCount = ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threadCount > RUNNING_MAX_THREADS ) {
+        threadCount = RUNNING_MAX_THREADS;
+    }
+    if ( threadCount > count / RUNNING_MIN_PER_THREAD ) {
+        threadCount = ( int ) ( count / RUNNING_MIN_PER_THREAD );
+    }
+    if ( threadCount < 1 ) {
+        threadCount = 1;
+    }
+
+    piOperands = ( int* ) malloc( sizeof( int ) * ( size_t ) ( count > 0 ? count : 1 ) );
+    plSubtotals = ( long* ) malloc( sizeof( long ) * ( size_t ) ( count > 0 ? count : 1 ) );
+    if ( piOperands == NULL || plSubtotals == NULL ) {
+        free( piOperands );
+        free( plSubtotals );
+        return FALSE;
+    }
+
+    for ( pChunk = pList->head ; pChunk != NULL ; pChunk = pChunk->next ) {
+        memcpy( piOperands + copied, pChunk->values, sizeof( int ) * ( size_t ) pChunk->count );
+        copied += pChunk->count;
+    }
+
+    for ( task = 0 ; task < threadCount ; task++ ) {
+        aTasks[task].piOperands = piOperands;
+        aTasks[task].plSubtotals = plSubtotals;
+        aTasks[task].start = count * task / threadCount;
+        aTasks[task].end = count * ( task + 1 ) / threadCount;
+        aTasks[task].pcOut = NULL;
+        aTasks[task].outLength = 0;
+    }
+
+    runPhase( aTasks, threadCount, RUNNING_PHASE_SCAN );
+
+    /* each range is offset by the totals of the ranges before it */
+    for ( task = 0 ; task < threadCount ; task++ ) {
+        aTasks[task].offset = offset;
+        offset += aTasks[task].total;
+    }
+
+    runPhase( aTasks, threadCount, RUNNING_PHASE_FORMAT );
+
+    fflush( pOutFile );
+    for ( task = 0 ; task < threadCount ; task++ ) {
+        ok = ok && writeAll( fileno( pOutFile ), aTasks[task].pcOut, aTasks[task].outLength );
+        free( aTasks[task].pcOut );
+    }
+
+    /* the last subtotal must be the session's total */
+    initAccumulator( &subtotal );
+    addAccumulator( &subtotal, offset );
+    ok = ok && compareAccumulator( &subtotal, pCurrTotal ) == 0;
+    freeAccumulator( &subtotal );
+
+    free( piOperands );
+    free( plSubtotals );
+    return ok;
+}
@@ -0,0 +1,30 @@
+#ifndef RUNNING_H
+#define RUNNING_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "intList.h"
+#include "accumulator.h"
+
+#define RUNNING_MAX_THREADS 256
+#define RUNNING_MIN_PER_THREAD 262144L /* smaller histories are scanned and formatted on the calling thread */
+#define RUNNING_LINE_SEPARATOR " -> "
+#define RUNNING_LINE_SEPARATOR_SIZE 4
+
+typedef struct RunningTask
+{
+	const int* piOperands; /* operands in the order entered */
+	long* plSubtotals; /* inclusive prefix sums, scanned within the task's range first, then offset */
+	long start; /* first operand of the task */
+	long end; /* one past the last operand */
+	long total; /* sum of the range */
+	long offset; /* sum of every operand before start */
+	char* pcOut; /* "operand -> subtotal" lines of the range */
+	size_t outLength;
+	int phase; /* RUNNING_PHASE_SCAN or RUNNING_PHASE_FORMAT */
+} RunningTask;
+
+
+int writeRunningTotals( IntList* pList, FILE* pOutFile, const Accumulator* pCurrTotal, int threadCount );
+
+#endif
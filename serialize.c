@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "serialize.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+/* "00" to "99", so integers are formatted two digits per division */
+static const char DIGIT_PAIRS[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+
+/**
+ * @brief  returns the amount of decimal digits in a magnitude.
+ * @retval returns 1 for 0.
+ */
+static size_t digitCount( unsigned long value ) {
+    size_t count = 1;
+
+    while ( value >= 100 ) {
+        value /= 100;
+        count += 2;
+    }
+
+    return count + ( value >= 10 );
+}
+
+
+/**
+ * @brief  writes a long in decimal, as "%ld" would.
+ * @note   digits are written from the right, two per division using DIGIT_PAIRS. No terminating '\0' is written, 
+ * * pcDest must hold SERIALIZE_MAX_LONG_LENGTH characters.
+ * @param  value: value to format (Type: Long).
+ * @param  pcDest: destination buffer (Type: Char array).
+ * @retval returns the amount of characters written.
+ */
+size_t formatLong( long value, char* pcDest ) {
+    unsigned long rest = value < 0 ? 0UL - ( unsigned long ) value : ( unsigned long ) value; /* valid for LONG_MIN too */
+    size_t length = digitCount( rest ) + ( value < 0 );
+    char* pcDigit = pcDest + length;
+    unsigned long pair;
+
+    while ( rest >= 100 ) {
+        pair = ( rest % 100 ) * 2;
+        rest /= 100;
+        *--pcDigit = DIGIT_PAIRS[pair + 1];
+        *--pcDigit = DIGIT_PAIRS[pair];
+    }
+
+    if ( rest >= 10 ) {
+        *--pcDigit = DIGIT_PAIRS[rest * 2 + 1];
+        *--pcDigit = DIGIT_PAIRS[rest * 2];
+    }
+    else {
+        *--pcDigit = ( char ) ( '0' + rest );
+    }
+
+    if ( value < 0 ) {
+        *--pcDigit = '-';
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief  writes an int in decimal, as "%d" would.
+ * @note   no terminating '\0' is written, pcDest must hold SERIALIZE_MAX_INT_LENGTH characters.
+ * @param  value: value to format (Type: Integer).
+ * @param  pcDest: destination buffer (Type: Char array).
+ * @retval returns the amount of characters written.
+ */
+size_t formatInt( int value, char* pcDest ) {
+    return formatLong( value, pcDest );
+}
+
+
+/**
+ * @brief  returns the amount of characters an int takes in decimal.
+ * @retval returns the length including a leading '-' if negative.
+ */
+static size_t intLength( int value ) {
+    return value < 0 ? digitCount( ( unsigned long ) -( long ) value ) + 1 : digitCount( ( unsigned long ) value );
+}
+
+
+/**
+ * @brief  returns the exact size of the text writeDataToFile produces for a session.
+ * @note   only counts the chunks in memory, the list must not have spilled any.
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
+ * @param  pCurrTotal: total of the operands (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns the size in bytes, including the final '\n'.
+ */
+size_t serializedLength( const IntList* pList, const Accumulator* pCurrTotal ) {
+    const IntListChunk* pChunk;
+    size_t length = accumulatorLength( pCurrTotal ) + 1; /* total and '\n' */
+    int index;
+
+    if ( pList->size > 1 ) {
+        length += ( size_t ) pList->size * 3; /* " + " between operands and " = " before the total */
+
+        for ( pChunk = pList->head ; pChunk != NULL ; pChunk = pChunk->next ) {
+            for ( index = 0 ; index < pChunk->count ; index++ ) {
+                length += intLength( pChunk->values[index] );
+            }
+        }
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief  formats a session exactly as writeDataToFile writes it: the operands last first joined by " + ", then 
+ * * " = " and the total, or only the total when there is at most one operand. The list must not have spilled any chunks.
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
+ * @param  pCurrTotal: total of the operands (Type: Pointer to a type defined struct called "Accumulator").
+ * @param  pcDest: destination holding serializedLength() characters, no '\0' is written (Type: Char array).
+ * @retval returns the amount of characters written.
+ */
+size_t serializeSession( const IntList* pList, const Accumulator* pCurrTotal, char* pcDest ) {
+    const IntListChunk* pChunk;
+    char* pcOut = pcDest;
+    int index;
+
+    if ( pList->size > 1 ) {
+        for ( pChunk = pList->tail ; pChunk != NULL ; pChunk = pChunk->prev ) {
+            for ( index = pChunk->count - 1 ; index >= 0 ; index-- ) {
+                pcOut += formatInt( pChunk->values[index], pcOut );
+                memcpy( pcOut, " + ", 3 );
+                pcOut += 3;
+            }
+        }
+        pcOut[-2] = '='; /* the separator after the first operand entered becomes " = " */
+    }
+
+    pcOut += formatAccumulator( pCurrTotal, pcOut );
+    *pcOut++ = '\n';
+
+    return ( size_t ) ( pcOut - pcDest );
+}
+
+
+/**
+ * @brief  writes all of a buffer to a file descriptor, retrying short writes.
+ * @retval returns TRUE if everything was written.
+ */
+static int writeText( int fd, const char* pcText, size_t length ) {
+    ssize_t written;
+
+    while ( length > 0 ) {
+        written = write( fd, pcText, length );
+
+        if ( written < 0 ) {
+            if ( errno != EINTR ) {
+                return FALSE;
+            }
+        }
+        else {
+            pcText += written;
+            length -= ( size_t ) written;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  writes the same text as serializeSession for a list that has spilled chunks, a block at a time.
+ * @note   the values are walked last first with the reverse iterator, which reads the spilled chunks back one at a time, 
+ * * so memory stays at one chunk and one SERIALIZE_STREAM_BLOCK_SIZE block however long the history is.
+ * @retval returns TRUE if everything was written.
+ */
+static int streamSerializedSession( int fd, const IntList* pList, const Accumulator* pCurrTotal ) {
+    IntListIterator iter;
+    char* pcBlock = ( char* ) malloc( SERIALIZE_STREAM_BLOCK_SIZE );
+    char* pcTotal;
+    size_t length = 0;
+    long remaining = pList->size;
+    int value, ok = TRUE;
+
+    if ( pcBlock == NULL ) {
+        return FALSE;
+    }
+
+    startIntListReverseIterator( pList, &iter );
+    while ( ok && nextIntReverse( &iter, &value ) ) {
+        if ( length > SERIALIZE_STREAM_BLOCK_SIZE - SERIALIZE_MAX_INT_LENGTH - 3 ) {
+            ok = writeText( fd, pcBlock, length );
+            length = 0;
+        }
+
+        length += formatInt( value, pcBlock + length );
+        memcpy( pcBlock + length, --remaining > 0 ? " + " : " = ", 3 ); /* the first operand entered comes last */
+        length += 3;
+    }
+    ok = ok && !iter.failed && writeText( fd, pcBlock, length );
+    free( pcBlock );
+
+    if ( ok && ( pcTotal = ( char* ) malloc( accumulatorLength( pCurrTotal ) + 1 ) ) != NULL ) {
+        length = formatAccumulator( pCurrTotal, pcTotal );
+        pcTotal[length++] = '\n';
+        ok = writeText( fd, pcTotal, length );
+        free( pcTotal );
+        return ok;
+    }
+
+    return FALSE;
+}
+
+
+/**
+ * @brief  allocates disk blocks for a range of a file, growing the file to cover it.
+ * @note   on failure the file is cut back to its previous size, so nothing is left past what a later write puts there.
+ * @retval returns TRUE if every block of the range is allocated.
+ */
+static int allocateRange( int fd, off_t offset, size_t length, off_t previousSize ) {
+    if ( posix_fallocate( fd, offset, ( off_t ) length ) == 0 ) {
+        return TRUE;
+    }
+
+    ftruncate( fd, previousSize ); /* a partial allocation may have grown it; if this fails the write that follows fails too */
+    return FALSE;
+}
+
+
+/**
+ * @brief  writes a session to a file descriptor at its current offset, formatted by serializeSession.
+ * @note   the output is sized first and formatted into one buffer sent with a single write(). Outputs of at least 
+ * * SERIALIZE_MMAP_THRESHOLD bytes going to a regular file opened for reading and writing are formatted straight into the 
+ * * mapped file instead, once posix_fallocate has reserved its blocks, so no copy of the text is held in memory. Lists 
+ * * that have spilled to disk are streamed out in SERIALIZE_STREAM_BLOCK_SIZE writes instead. Either way the offset ends 
+ * * just after the text.
+ * @param  fd: file descriptor to write to (Type: Integer).
+ * @param  pList: list that holds the input sequences for the calculator (Type: Pointer to a type defined struct called "IntList").
+ * @param  pCurrTotal: total of the operands (Type: Pointer to a type defined struct called "Accumulator").
+ * @retval returns TRUE if everything was written.
+ */
+int writeSerializedSession( int fd, const IntList* pList, const Accumulator* pCurrTotal ) {
+    size_t length;
+    size_t pageOffset;
+    struct stat info;
+    off_t offset;
+    char* pcText;
+    char* pcMap;
+    int ok;
+
+    if ( pList->spilledChunks > 0 ) {
+        return streamSerializedSession( fd, pList, pCurrTotal );
+    }
+
+    length = serializedLength( pList, pCurrTotal );
+
+    /* the blocks are allocated up front: a store through the mapping past what the disk can hold raises SIGBUS, 
+       where posix_fallocate fails with ENOSPC and the buffered write below reports it */
+    if ( length >= SERIALIZE_MMAP_THRESHOLD && fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) && ( offset = lseek( fd, 0, SEEK_CUR ) ) >= 0 
+         && allocateRange( fd, offset, length, info.st_size ) ) {
+
+        pageOffset = ( size_t ) ( offset % sysconf( _SC_PAGESIZE ) ); /* mappings start on a page boundary */
+        pcMap = ( char* ) mmap( NULL, length + pageOffset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset - ( off_t ) pageOffset );
+
+        if ( pcMap != MAP_FAILED ) {
+            serializeSession( pList, pCurrTotal, pcMap + pageOffset );
+            munmap( pcMap, length + pageOffset );
+            return lseek( fd, offset + ( off_t ) length, SEEK_SET ) >= 0;
+        }
+        /* not mappable (i.e. opened write-only), fall back to a buffer */
+    }
+
+    if ( ( pcText = ( char* ) malloc( length ) ) == NULL ) {
+        return FALSE;
+    }
+    serializeSession( pList, pCurrTotal, pcText );
+
+    ok = writeText( fd, pcText, length );
+
+    free( pcText );
+    return ok;
+}
+
+
+/**
+ * @brief  flushes a fully written temporary output file to disk and renames it over the output file.
+ * @note   the output file is replaced in one step, so a crash or a full disk while writing leaves the previous output 
+ * * (and the journal, which is kept) rather than an empty or partial file; --resume then still finds the whole history. 
+ * * The directory is synced too, and only once that succeeds is the rename reported, so a caller removing the journal 
+ * * on TRUE never loses both to a power cut. The temporary file is closed either way and removed if it was not renamed.
+ * @param  pTempFile: temporary output file, closed by this (Type: Pointer to the type 'FILE').
+ * @param  pcTempPath: path of the temporary file (Type: Char array).
+ * @param  pcPath: output file to replace (Type: Char array).
+ * @param  written: TRUE if the session was written to the temporary file without error (Type: Integer).
+ * @retval returns TRUE if the output file durably holds the session, FALSE otherwise.
+ */
+int replaceOutputFile( FILE* pTempFile, const char* pcTempPath, const char* pcPath, int written ) {
+    const char* pcSlash = strrchr( pcPath, '/' );
+    char* pcDirectory;
+    int fd;
+
+    written = ( fflush( pTempFile ) == 0 ) && ( fsync( fileno( pTempFile ) ) == 0 ) && written;
+    written = ( fclose( pTempFile ) == 0 ) && written;
+
+    if ( !written || rename( pcTempPath, pcPath ) != 0 ) {
+        unlink( pcTempPath );
+        return FALSE;
+    }
+
+    pcDirectory = ( char* ) malloc( strlen( pcPath ) + 2 );
+    if ( pcSlash == NULL ) {
+        strcpy( pcDirectory, "." );
+    }
+    else {
+        memcpy( pcDirectory, pcPath, ( size_t ) ( pcSlash - pcPath ) + 1 ); /* keep the slash, so "/file" gives "/" */
+        pcDirectory[pcSlash - pcPath + 1] = '\0';
+    }
+
+    written = FALSE;
+    if ( ( fd = open( pcDirectory, O_RDONLY ) ) >= 0 ) {
+        written = ( fsync( fd ) == 0 );
+        close( fd );
+    }
+
+    free( pcDirectory );
+    return written;
+}
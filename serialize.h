@@ -0,0 +1,22 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "intList.h"
+#include "accumulator.h"
+
+#define SERIALIZE_MMAP_THRESHOLD ( 64UL * 1024 * 1024 ) /* outputs this large are formatted straight into the mapped file */
+#define SERIALIZE_STREAM_BLOCK_SIZE ( 1024 * 1024 ) /* write size when streaming a list with spilled chunks */
+#define SERIALIZE_MAX_INT_LENGTH 11 /* "-2147483648" */
+#define SERIALIZE_MAX_LONG_LENGTH 20 /* "-9223372036854775808" */
+
+
+size_t formatLong( long value, char* pcDest );
+size_t formatInt( int value, char* pcDest );
+size_t serializedLength( const IntList* pList, const Accumulator* pCurrTotal );
+size_t serializeSession( const IntList* pList, const Accumulator* pCurrTotal, char* pcDest );
+int writeSerializedSession( int fd, const IntList* pList, const Accumulator* pCurrTotal );
+int replaceOutputFile( FILE* pTempFile, const char* pcTempPath, const char* pcPath, int written );
+
+#endif
@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "binfmt.h"
+#include "running.h"
+
+static volatile sig_atomic_t stopRequested = FALSE; /* set by SIGINT or SIGTERM */
+
+
+/**
+ * @brief  signal handler asking the event loop to finish every session and stop.
+ * @retval None
+ */
+static void requestStop( int signalNumber ) {
+    ( void ) signalNumber;
+    stopRequested = TRUE;
+}
+
+
+/**
+ * @brief  builds the per-session file name <prefix>.<id><suffix>.
+ * @retval returns the malloc'ed name.
+ */
+static char* sessionPath( const char* pcPrefix, long id, const char* pcSuffix ) {
+    char* pcPath = ( char* ) malloc( strlen( pcPrefix ) + strlen( pcSuffix ) + 24 );
+
+    sprintf( pcPath, "%s.%ld%s", pcPrefix, id, pcSuffix );
+    return pcPath;
+}
+
+
+/**
+ * @brief  creates a file that must not exist yet.
+ * @retval returns TRUE if it was created, FALSE with errno set otherwise (EEXIST if it already existed).
+ */
+static int createExclusive( const char* pcPath ) {
+    int fd = open( pcPath, O_WRONLY | O_CREAT | O_EXCL, 0644 );
+
+    if ( fd < 0 ) {
+        return FALSE;
+    }
+    close( fd );
+    return TRUE;
+}
+
+
+/**
+ * @brief  takes the next session id whose output file, and journal if journaling, do not exist yet.
+ * @note   both files are created with O_EXCL, so ids left behind by an earlier server (finished outputs, or journals of 
+ * * sessions that crashed) are skipped rather than overwritten, appended to or removed. A skipped journal is reported 
+ * * so it can be recovered. The output file stays empty until the session ends.
+ * @param  pcOutPrefix: output files are named <pcOutPrefix>.<id> (Type: Char array).
+ * @param  plNextId: first id to try, advanced past the id returned (Type: Pointer to Long).
+ * @param  useJournal: TRUE to reserve <pcOutPrefix>.<id>.journal too (Type: Integer).
+ * @retval returns the reserved id, -1 if the files could not be created.
+ */
+static long reserveSessionId( const char* pcOutPrefix, long* plNextId, int useJournal ) {
+    char* pcOutPath;
+    char* pcJournalPath;
+    long id = -1;
+    int reserved, taken, failed = FALSE;
+
+    while ( id < 0 && !failed ) {
+        pcOutPath = sessionPath( pcOutPrefix, *plNextId, "" );
+        pcJournalPath = sessionPath( pcOutPrefix, *plNextId, ".journal" );
+
+        reserved = !useJournal || createExclusive( pcJournalPath );
+        taken = !reserved && errno == EEXIST;
+        if ( taken ) {
+            fprintf( stderr, "Skipping session %ld, its journal is left from an earlier server; recover it with "
+                     "./calculator --replay /dev/null --journal %s %s\n", *plNextId, pcJournalPath, pcOutPath );
+        }
+
+        if ( reserved && !createExclusive( pcOutPath ) ) {
+            taken = ( errno == EEXIST );
+            if ( useJournal ) {
+                unlink( pcJournalPath );
+            }
+            reserved = FALSE;
+        }
+
+        if ( reserved ) {
+            id = *plNextId;
+        }
+        else if ( !taken ) {
+            failed = TRUE; /* not a clash, i.e. the directory is not writable */
+        }
+
+        ( *plNextId )++;
+        free( pcOutPath );
+        free( pcJournalPath );
+    }
+
+    return id;
+}
+
+
+/**
+ * @brief  sets O_NONBLOCK on a file descriptor.
+ * @retval returns TRUE on success.
+ */
+static int setNonBlocking( int fd ) {
+    int flags = fcntl( fd, F_GETFL );
+
+    return flags >= 0 && fcntl( fd, F_SETFL, flags | O_NONBLOCK ) == 0;
+}
+
+
+/**
+ * @brief  creates a listening Unix stream socket.
+ * @note   a stale socket left at the path by an earlier server is replaced; any other kind of file is not.
+ * @retval returns the non-blocking listening descriptor, -1 on error.
+ */
+static int listenUnix( const char* pcSocketPath ) {
+    struct sockaddr_un address;
+    struct stat info;
+    int fd;
+
+    if ( strlen( pcSocketPath ) >= sizeof( address.sun_path ) ) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    strcpy( address.sun_path, pcSocketPath );
+
+    if ( lstat( pcSocketPath, &info ) == 0 && S_ISSOCK( info.st_mode ) ) {
+        unlink( pcSocketPath );
+    }
+
+    if ( ( fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 ) {
+        return -1;
+    }
+
+    if ( bind( fd, ( struct sockaddr* ) &address, sizeof( address ) ) != 0 || listen( fd, SERVER_BACKLOG ) != 0 || !setNonBlocking( fd ) ) {
+        close( fd );
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/**
+ * @brief  turns away one pending connection while the server is out of file descriptors.
+ * @note   accept fails with EMFILE or ENFILE but leaves the connection queued, so level-triggered epoll would report the
+ * * listener again at once and the loop would spin. The spare descriptor is closed to make room, the connection is accepted
+ * * and closed, and the spare is reopened. If it cannot be reopened the listener is taken out of epoll until a session ends.
+ * @param  piSpareFd: descriptor held in reserve for this, -1 if there is none (Type: Pointer to Integer).
+ * @retval returns TRUE if the listener was taken out of epoll.
+ */
+static int refuseConnection( int epollFd, int listenFd, int* piSpareFd ) {
+    struct epoll_event event;
+    int fd;
+
+    if ( *piSpareFd >= 0 ) {
+        close( *piSpareFd );
+        if ( ( fd = accept( listenFd, NULL, NULL ) ) >= 0 ) {
+            close( fd );
+        }
+        *piSpareFd = open( "/dev/null", O_RDONLY );
+    }
+
+    if ( *piSpareFd >= 0 ) {
+        return FALSE;
+    }
+
+    event.events = 0;
+    event.data.ptr = NULL;
+    epoll_ctl( epollFd, EPOLL_CTL_MOD, listenFd, &event );
+    return TRUE;
+}
+
+
+/**
+ * @brief  starts a session for a newly accepted connection and draws its first frame.
+ * @note   id must have been reserved with reserveSessionId; its files are removed again if the client cannot be started.
+ * @retval returns the client, NULL if it could not be registered with epoll.
+ */
+static Client* openClient( int epollFd, int fd, long id, const char* pcOutPrefix, int layout, int useJournal, long syncIntervalMs ) {
+    Client* pClient = ( Client* ) malloc( sizeof( Client ) );
+    struct epoll_event event;
+    char* pcOutPath;
+
+    pClient->fd = fd;
+    pClient->id = id;
+    pClient->pcJournalPath = NULL;
+    initSession( &pClient->session, layout == SERVER_RANDOM_LAYOUT ? rand() % KEYBOARD_LAYOUT_COUNT : layout );
+
+    if ( useJournal ) {
+        pClient->pcJournalPath = sessionPath( pcOutPrefix, id, ".journal" );
+
+        if ( ( pClient->session.pJournal = openJournal( pClient->pcJournalPath, syncIntervalMs ) ) == NULL ) {
+            fprintf( stderr, "Could not open journal, journaling disabled: %s\n", pClient->pcJournalPath );
+            unlink( pClient->pcJournalPath ); /* the empty file reserveSessionId created */
+            free( pClient->pcJournalPath );
+            pClient->pcJournalPath = NULL;
+        }
+    }
+
+    pClient->pRenderer = createRenderer( fd );
+
+    event.events = EPOLLIN;
+    event.data.ptr = pClient;
+
+    if ( epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &event ) != 0 ) {
+        pcOutPath = sessionPath( pcOutPrefix, id, "" );
+        unlink( pcOutPath );
+        free( pcOutPath );
+        closeJournal( pClient->session.pJournal, pClient->pcJournalPath );
+        free( pClient->pcJournalPath );
+        freeRenderer( pClient->pRenderer );
+        freeSession( &pClient->session );
+        free( pClient );
+        return NULL;
+    }
+
+    renderCalculator( pClient->pRenderer, &pClient->session );
+    return pClient;
+}
+
+
+/**
+ * @brief  ends a session: writes its output file <prefix>.<id> in the given format, removes its journal and disconnects the client.
+ * @note   the output is written to <prefix>.<id>.tmp and renamed over the reserved file with replaceOutputFile, so the journal 
+ * * is only removed once the whole output is on disk. The client's socket is closed first, which frees a descriptor for the 
+ * * temporary file even when the server has run out.
+ * @retval None
+ */
+static void closeClient( int epollFd, Client* pClient, const char* pcOutPrefix, int format ) {
+    char* pcOutPath = sessionPath( pcOutPrefix, pClient->id, "" );
+    char* pcTempPath = sessionPath( pcOutPrefix, pClient->id, ".tmp" );
+    FILE* pOutFile;
+    int written = FALSE;
+
+    epoll_ctl( epollFd, EPOLL_CTL_DEL, pClient->fd, NULL );
+    freeRenderer( pClient->pRenderer ); /* back to the client's normal screen, if it is still listening */
+    close( pClient->fd );
+
+    if ( ( pOutFile = fopen( pcTempPath, "wb" ) ) == NULL ) {
+        fprintf( stderr, "Could not open output file: %s\n", pcTempPath );
+    }
+    else {
+        if ( format == OUTPUT_FORMAT_BIN ) {
+            written = writeBinaryFile( pClient->session.pList, pOutFile, &pClient->session.total );
+        }
+        else if ( format == OUTPUT_FORMAT_RUNNING ) {
+            written = writeRunningTotals( pClient->session.pList, pOutFile, &pClient->session.total, 1 ); /* stay on the event loop's thread */
+        }
+        else {
+            written = writeDataToFile( pClient->session.pList, pOutFile, &pClient->session.total );
+        }
+        if ( !( written = replaceOutputFile( pOutFile, pcTempPath, pcOutPath, written ) ) ) {
+            fprintf( stderr, "Could not write output file: %s\n", pcOutPath );
+        }
+    }
+
+    /* the journal is only removed once the output file holds the session */
+    closeJournal( pClient->session.pJournal, written ? pClient->pcJournalPath : NULL );
+    pClient->session.pJournal = NULL;
+
+    freeSession( &pClient->session );
+    free( pClient->pcJournalPath );
+    free( pcTempPath );
+    free( pcOutPath );
+    free( pClient );
+}
+
+
+/**
+ * @brief  returns the milliseconds passed since a CLOCK_MONOTONIC time.
+ * @retval returns the elapsed milliseconds.
+ */
+static long millisecondsSince( const struct timespec* pSince ) {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( now.tv_sec - pSince->tv_sec ) * 1000 + ( now.tv_nsec - pSince->tv_nsec ) / 1000000;
+}
+
+
+/**
+ * @brief  syncs the journal of every open session that has unsynced records.
+ * @note   run once per sync interval, so a record waits at most that long even if its session goes idle right after it.
+ * @retval None
+ */
+static void syncClientJournals( Client** ppClients, long clientCount ) {
+    long index;
+
+    for ( index = 0 ; index < clientCount ; index++ ) {
+        if ( journalSyncWaitMs( ppClients[index]->session.pJournal ) >= 0 ) {
+            syncJournal( ppClients[index]->session.pJournal );
+        }
+    }
+}
+
+
+/**
+ * @brief  runs the keystrokes waiting on a client's socket through its session and redraws it once.
+ * @note   reads at most INPUT_BATCH_SIZE bytes so one fast client cannot starve the others; level-triggered epoll reports 
+ * * the rest on the next pass.
+ * @retval returns TRUE if the session is over ("=" confirmed, or the client disconnected).
+ */
+static int serviceClient( Client* pClient ) {
+    char acInput[INPUT_BATCH_SIZE];
+    ssize_t bytesRead = read( pClient->fd, acInput, INPUT_BATCH_SIZE );
+
+    if ( bytesRead < 0 ) {
+        return !( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR );
+    }
+    if ( bytesRead == 0 ) {
+        return TRUE; /* client hung up, end the session as if "=" was pressed */
+    }
+
+    if ( applyKeystrokes( &pClient->session, acInput, ( size_t ) bytesRead, NULL ) ) {
+        return TRUE;
+    }
+
+    renderCalculator( pClient->pRenderer, &pClient->session );
+    return FALSE;
+}
+
+
+/**
+ * @brief  serves calculator sessions to every client that connects to a Unix socket, all on one epoll loop.
+ * @note   each connection gets its own session (layout, cursor, operand history and total) and is drawn to over its socket 
+ * * as if it were a terminal, so a raw-mode client such as socat works. When a client confirms "=" or disconnects its 
+ * * operands and total are written to <prefix>.<id> with writeDataToFile (or writeBinaryFile), ids counting up from 1 and 
+ * * skipping ids whose output file or journal already exists, so an earlier server's files are never overwritten, appended 
+ * * to or removed (a crashed session's journal stays for recovery). Runs until SIGINT or 
+ * * SIGTERM, then finishes every open session the same way. The open file limit is raised to its hard limit so thousands 
+ * * of sessions can be held at once. While journaled sessions are open, epoll_wait times out once per sync interval to 
+ * * sync their journals, so idle sessions' records are not left unsynced. Out of file descriptors, new connections are
+ * * accepted and closed at once (see refuseConnection) instead of being left queued.
+ * @param  pcSocketPath: path to listen on (Type: Char array).
+ * @param  pcOutPrefix: output files are named <pcOutPrefix>.<id> (Type: Char array).
+ * @param  layout: keyboard layout for every session, or SERVER_RANDOM_LAYOUT (Type: Integer).
+ * @param  format: OUTPUT_FORMAT_TEXT, OUTPUT_FORMAT_BIN or OUTPUT_FORMAT_RUNNING (Type: Integer).
+ * @param  useJournal: TRUE to journal each session to <pcOutPrefix>.<id>.journal (Type: Integer).
+ * @param  syncIntervalMs: longest a journal record waits for fdatasync (Type: Long).
+ * @retval returns the amount of sessions served, -1 if the socket could not be set up.
+ */
+long serveSessions( const char* pcSocketPath, const char* pcOutPrefix, int layout, int format, int useJournal, long syncIntervalMs ) {
+    struct epoll_event aEvents[SERVER_MAX_EVENTS];
+    struct epoll_event event;
+    struct sigaction action;
+    struct rlimit limit;
+    struct timespec lastSweep; /* last time every open journal was synced */
+    Client** ppClients = NULL; /* open sessions, so they can be finished on shutdown */
+    Client* pClient;
+    long clientCount = 0, clientCapacity = 0;
+    long served = 0;
+    long nextId = 1, id; /* session ids are tried counting up from 1 */
+    int listenFd, epollFd, fd;
+    int spareFd; /* closed to turn a connection away when out of file descriptors */
+    int listenerPaused = FALSE, refusing = FALSE;
+    int ready, index;
+    long timeoutMs;
+
+    if ( getrlimit( RLIMIT_NOFILE, &limit ) == 0 && limit.rlim_cur < limit.rlim_max ) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit( RLIMIT_NOFILE, &limit );
+    }
+
+    if ( ( listenFd = listenUnix( pcSocketPath ) ) < 0 ) {
+        return -1;
+    }
+
+    if ( ( epollFd = epoll_create( SERVER_MAX_EVENTS ) ) < 0 ) {
+        close( listenFd );
+        unlink( pcSocketPath );
+        return -1;
+    }
+
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; /* the listening socket is the only event without a client */
+    epoll_ctl( epollFd, EPOLL_CTL_ADD, listenFd, &event );
+    spareFd = open( "/dev/null", O_RDONLY );
+
+    /* no SA_RESTART, so a signal wakes epoll_wait; writes to a client that has gone fail instead of killing the server */
+    memset( &action, 0, sizeof( action ) );
+    sigemptyset( &action.sa_mask );
+    action.sa_handler = requestStop;
+    sigaction( SIGINT, &action, NULL );
+    sigaction( SIGTERM, &action, NULL );
+    action.sa_handler = SIG_IGN;
+    sigaction( SIGPIPE, &action, NULL );
+
+    clock_gettime( CLOCK_MONOTONIC, &lastSweep );
+
+    while ( !stopRequested ) {
+        /* with journaled sessions open, wake up in time for the next sync sweep (an interval of 0 syncs every record) */
+        timeoutMs = -1;
+        if ( useJournal && syncIntervalMs > 0 && clientCount > 0 ) {
+            timeoutMs = syncIntervalMs - millisecondsSince( &lastSweep );
+            if ( timeoutMs < 0 ) {
+                timeoutMs = 0;
+            }
+        }
+
+        ready = epoll_wait( epollFd, aEvents, SERVER_MAX_EVENTS, ( int ) timeoutMs );
+
+        if ( ready < 0 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+
+        for ( index = 0 ; index < ready ; index++ ) {
+            pClient = ( Client* ) aEvents[index].data.ptr;
+
+            if ( pClient == NULL ) { /* accept every pending connection */
+                while ( ( fd = accept( listenFd, NULL, NULL ) ) >= 0 ) {
+                    if ( !setNonBlocking( fd ) ) {
+                        close( fd );
+                        continue;
+                    }
+                    if ( ( id = reserveSessionId( pcOutPrefix, &nextId, useJournal ) ) < 0 ) {
+                        fprintf( stderr, "Could not create the output file of a new session: %s.%ld\n", pcOutPrefix, nextId - 1 );
+                        close( fd );
+                        continue;
+                    }
+                    if ( ( pClient = openClient( epollFd, fd, id, pcOutPrefix, layout, useJournal, syncIntervalMs ) ) == NULL ) {
+                        close( fd );
+                        continue;
+                    }
+
+                    if ( clientCount == clientCapacity ) {
+                        clientCapacity = clientCapacity > 0 ? clientCapacity * 2 : 64;
+                        ppClients = ( Client** ) realloc( ppClients, sizeof( Client* ) * ( size_t ) clientCapacity );
+                    }
+                    pClient->index = clientCount;
+                    ppClients[clientCount++] = pClient;
+                    served++;
+                    refusing = FALSE;
+                }
+
+                if ( errno == EMFILE || errno == ENFILE ) {
+                    if ( !refusing ) { /* reported once per run of refusals, not per connection */
+                        perror( "accept, refusing connections" );
+                        refusing = TRUE;
+                    }
+                    listenerPaused = refuseConnection( epollFd, listenFd, &spareFd );
+                }
+                else if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED ) {
+                    perror( "accept" );
+                }
+            }
+
+            else if ( serviceClient( pClient ) ) {
+                ppClients[pClient->index] = ppClients[--clientCount];
+                ppClients[pClient->index]->index = pClient->index;
+                closeClient( epollFd, pClient, pcOutPrefix, format );
+
+                if ( listenerPaused ) { /* a descriptor is free again */
+                    spareFd = open( "/dev/null", O_RDONLY );
+                    event.events = EPOLLIN;
+                    event.data.ptr = NULL;
+                    epoll_ctl( epollFd, EPOLL_CTL_MOD, listenFd, &event );
+                    listenerPaused = FALSE;
+                }
+            }
+        }
+
+        if ( timeoutMs >= 0 && millisecondsSince( &lastSweep ) >= syncIntervalMs ) {
+            syncClientJournals( ppClients, clientCount );
+            clock_gettime( CLOCK_MONOTONIC, &lastSweep );
+        }
+    }
+
+    /* finish the sessions still open */
+    while ( clientCount > 0 ) {
+        closeClient( epollFd, ppClients[--clientCount], pcOutPrefix, format );
+    }
+
+    free( ppClients );
+    if ( spareFd >= 0 ) {
+        close( spareFd );
+    }
+    close( epollFd );
+    close( listenFd );
+    unlink( pcSocketPath );
+
+    return served;
+}
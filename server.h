@@ -0,0 +1,24 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "module.h"
+#include "render.h"
+
+#define SERVER_MAX_EVENTS 256 /* readiness events handled per epoll_wait */
+#define SERVER_BACKLOG 1024
+#define SERVER_RANDOM_LAYOUT -1 /* give each connection a layout chosen with rand() */
+
+typedef struct Client
+{
+	int fd; /* connected socket, non-blocking */
+	long id; /* sequence number whose files were free when it connected, names the output file <prefix>.<id> */
+	long index; /* position in the server's client array */
+	Session session; /* this connection's calculator */
+	Renderer* pRenderer; /* draws the calculator back to the client */
+	char* pcJournalPath; /* malloc'ed journal path, NULL if the session is not journaled */
+} Client;
+
+
+long serveSessions( const char* pcSocketPath, const char* pcOutPrefix, int layout, int format, int useJournal, long syncIntervalMs );
+
+#endif
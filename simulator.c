@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "simulator.h"
+#include "workload.h"
+
+
+/**
+ * @brief  returns a monotonic timestamp in nanoseconds.
+ * @retval returns the timestamp.
+ */
+static double nowNs() {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( double ) now.tv_sec * 1e9 + ( double ) now.tv_nsec;
+}
+
+
+/**
+ * @brief  runs one virtual session's workload on every layout.
+ * @note   the session's operands come from a generator seeded by the pool seed and the session index alone, so the
+ * * results do not depend on which worker runs the session, and every layout is measured on the same operands. The
+ * * keystrokes are generated first, then fed to userInterfaceManager one byte at a time and timed.
+ * @retval None
+ */
+static void runSession( SimWorker* pWorker, unsigned long session ) {
+    const SimPool* pPool = pWorker->local.pPool;
+    SimLayoutTotals* pTotals;
+    Session calculator;
+    Keyboard keyboard;
+    unsigned long state, sessionSeed;
+    size_t keyCount, index;
+    long sum;
+    int layout, operand, value, cursorKey, confirmed;
+    double start;
+
+    sessionSeed = pPool->seed ^ ( ( session + 1 ) * 0x9E3779B97F4A7C15UL );
+    if ( sessionSeed == 0 ) {
+        sessionSeed = 1;
+    }
+
+    for ( layout = 0 ; layout < KEYBOARD_LAYOUT_COUNT ; layout++ ) {
+        pTotals = &pWorker->local.aTotals[layout];
+        constructKeyboard( &keyboard, layout );
+        state = sessionSeed;
+        cursorKey = KEYBOARD_START_KEY;
+        keyCount = 0;
+        sum = 0;
+
+        for ( operand = 0 ; operand < pPool->operandsPerSession ; operand++ ) {
+            value = randomOperand( &state );
+            sum += value;
+            keyCount += keysForOperand( &keyboard, &cursorKey, value, pWorker->local.pcKeys + keyCount );
+        }
+        keyCount += keysForGlyph( &keyboard, &cursorKey, '=', pWorker->local.pcKeys + keyCount );
+
+        initSession( &calculator, layout );
+        confirmed = FALSE;
+
+        start = nowNs();
+        for ( index = 0 ; index < keyCount && !confirmed ; index++ ) {
+            confirmed = userInterfaceManager( &calculator, &pWorker->local.pcKeys[index] );
+        }
+        pTotals->elapsedNs += nowNs() - start;
+
+        pTotals->sessions++;
+        pTotals->operands += ( unsigned long ) pPool->operandsPerSession;
+        pTotals->keystrokes += ( unsigned long ) index;
+        if ( !confirmed || calculator.total.isBig || calculator.total.small != sum || calculator.pList->size != pPool->operandsPerSession ) {
+            pTotals->mismatches++;
+        }
+
+        freeSession( &calculator );
+    }
+}
+
+
+/**
+ * @brief  takes up to SIM_BATCH sessions from the front of a worker's own range.
+ * @retval returns TRUE if sessions were taken, with [*pulFirst, *pulEnd) set to them.
+ */
+static int claimBatch( SimWorker* pWorker, unsigned long* pulFirst, unsigned long* pulEnd ) {
+    unsigned long range = __atomic_load_n( &pWorker->range, __ATOMIC_ACQUIRE );
+    unsigned long next, end;
+
+    do {
+        next = SIM_RANGE_NEXT( range );
+        end = SIM_RANGE_END( range );
+
+        if ( next >= end ) {
+            return FALSE;
+        }
+
+        *pulFirst = next;
+        *pulEnd = ( end - next > SIM_BATCH ) ? next + SIM_BATCH : end;
+    } while ( !__atomic_compare_exchange_n( &pWorker->range, &range, SIM_RANGE( *pulEnd, end ), FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) );
+
+    return TRUE;
+}
+
+
+/**
+ * @brief  steals the back half of the first other worker's range that still has sessions, into the thief's own range.
+ * @note   the thief's range is empty while it steals, and nobody steals from an empty range, so the thief can store
+ * * its new range without a CAS.
+ * @retval returns TRUE if sessions were stolen, FALSE if every other range was empty.
+ */
+static int stealRange( SimWorker* pThief ) {
+    SimPool* pPool = pThief->local.pPool;
+    SimWorker* pVictim;
+    unsigned long range, next, end, half;
+    int offset;
+
+    for ( offset = 1 ; offset < pPool->workerCount ; offset++ ) {
+        pVictim = &pPool->paWorkers[( pThief->local.index + offset ) % pPool->workerCount];
+        range = __atomic_load_n( &pVictim->range, __ATOMIC_ACQUIRE );
+
+        for ( ;; ) {
+            next = SIM_RANGE_NEXT( range );
+            end = SIM_RANGE_END( range );
+
+            if ( next >= end ) {
+                break; /* empty, try the next worker */
+            }
+
+            half = ( end - next + 1 ) / 2;
+            if ( __atomic_compare_exchange_n( &pVictim->range, &range, SIM_RANGE( next, end - half ), FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) {
+                __atomic_store_n( &pThief->range, SIM_RANGE( end - half, end ), __ATOMIC_RELEASE );
+                pThief->local.steals++;
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+
+/**
+ * @brief  worker: runs sessions from its own range a batch at a time, stealing from the others once it runs dry.
+ * @note   stops once a pass over every other worker finds nothing to steal; sessions another thief is holding in hand at
+ * * that moment are run by that thief.
+ * @retval returns NULL.
+ */
+static void* runWorker( void* pArg ) {
+    SimWorker* pWorker = ( SimWorker* ) pArg;
+    unsigned long first, end;
+
+    do {
+        while ( claimBatch( pWorker, &first, &end ) ) {
+            for ( ; first < end ; first++ ) {
+                runSession( pWorker, first );
+            }
+        }
+    } while ( stealRange( pWorker ) );
+
+    return NULL;
+}
+
+
+int main( int argc, char *argv[] ) {
+    SimPool pool;
+    SimLayoutTotals total;
+    pthread_t aThreads[SIM_MAX_THREADS];
+    int aStarted[SIM_MAX_THREADS];
+    Keyboard keyboard;
+    long sessions = SIM_DEFAULT_SESSIONS;
+    int operands = SIM_DEFAULT_OPERANDS;
+    int threadCount = 0;
+    int worker, layout;
+    unsigned long steals = 0, mismatches = 0;
+    double start, wallNs;
+    void* pMemory;
+
+    if ( argc > 1 ) {
+        sessions = atol( argv[1] );
+    }
+    if ( argc > 2 ) {
+        operands = atoi( argv[2] );
+    }
+    if ( argc > 3 ) {
+        threadCount = atoi( argv[3] );
+    }
+    pool.seed = ( argc > 4 ) ? strtoul( argv[4], NULL, 10 ) : SIM_DEFAULT_SEED;
+
+    if ( sessions < 1 || ( unsigned long ) sessions > SIM_MAX_SESSIONS || operands < 1 || operands > SIM_MAX_OPERANDS
+         || threadCount < 0 || pool.seed == 0 ) {
+        printf( "Please provide argument correctly: ./calculator_sim [sessions] [operandsPerSession <= %d] [threads, 0 for one per processor] [seed > 0]\n", SIM_MAX_OPERANDS );
+        return 1;
+    }
+
+    if ( threadCount == 0 ) {
+        threadCount = ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threadCount > SIM_MAX_THREADS ) {
+        threadCount = SIM_MAX_THREADS;
+    }
+    if ( threadCount < 1 ) {
+        threadCount = 1;
+    }
+
+    /* the transition tables are built on first use, so build every layout's before the workers share them */
+    for ( layout = 0 ; layout < KEYBOARD_LAYOUT_COUNT ; layout++ ) {
+        constructKeyboard( &keyboard, layout );
+    }
+
+    if ( posix_memalign( &pMemory, SIM_CACHE_LINE, sizeof( SimWorker ) * ( size_t ) threadCount ) != 0 ) {
+        return 1;
+    }
+    pool.paWorkers = ( SimWorker* ) pMemory;
+    pool.workerCount = threadCount;
+    pool.operandsPerSession = operands;
+
+    /* every worker starts with an equal share, stealing evens out what is left */
+    for ( worker = 0 ; worker < threadCount ; worker++ ) {
+        memset( &pool.paWorkers[worker], 0, sizeof( SimWorker ) );
+        pool.paWorkers[worker].range = SIM_RANGE( sessions * worker / threadCount, sessions * ( worker + 1 ) / threadCount );
+        pool.paWorkers[worker].local.pPool = &pool;
+        pool.paWorkers[worker].local.index = worker;
+        pool.paWorkers[worker].local.pcKeys = ( char* ) malloc( ( size_t ) ( operands + 1 ) * WORKLOAD_MAX_KEYS_PER_OPERAND );
+
+        if ( pool.paWorkers[worker].local.pcKeys == NULL ) {
+            fprintf( stderr, "Could not allocate the keystroke buffers of %d workers\n", threadCount );
+            while ( worker > 0 ) {
+                free( pool.paWorkers[--worker].local.pcKeys );
+            }
+            free( pool.paWorkers );
+            return 1;
+        }
+    }
+
+    start = nowNs();
+    for ( worker = 1 ; worker < threadCount ; worker++ ) {
+        aStarted[worker] = ( pthread_create( &aThreads[worker], NULL, &runWorker, &pool.paWorkers[worker] ) == 0 );
+    }
+    runWorker( &pool.paWorkers[0] ); /* a worker whose thread could not start has its range stolen */
+    for ( worker = 1 ; worker < threadCount ; worker++ ) {
+        if ( aStarted[worker] ) {
+            pthread_join( aThreads[worker], NULL );
+        }
+    }
+    wallNs = nowNs() - start;
+
+    for ( layout = 0 ; layout < KEYBOARD_LAYOUT_COUNT ; layout++ ) {
+        memset( &total, 0, sizeof( total ) );
+
+        for ( worker = 0 ; worker < threadCount ; worker++ ) {
+            total.sessions += pool.paWorkers[worker].local.aTotals[layout].sessions;
+            total.operands += pool.paWorkers[worker].local.aTotals[layout].operands;
+            total.keystrokes += pool.paWorkers[worker].local.aTotals[layout].keystrokes;
+            total.elapsedNs += pool.paWorkers[worker].local.aTotals[layout].elapsedNs;
+            total.mismatches += pool.paWorkers[worker].local.aTotals[layout].mismatches;
+        }
+        mismatches += total.mismatches;
+
+        printf( "{\"layout\":%d,\"sessions\":%lu,\"operands\":%lu,\"keystrokes\":%lu,\"keys_per_operand\":%.3f,\"keys_per_sec\":%.0f,\"mismatches\":%lu}\n",
+                layout, total.sessions, total.operands, total.keystrokes, ( double ) total.keystrokes / ( double ) total.operands,
+                total.elapsedNs > 0 ? ( double ) total.keystrokes * 1e9 / total.elapsedNs : 0.0, total.mismatches );
+    }
+
+    for ( worker = 0 ; worker < threadCount ; worker++ ) {
+        steals += pool.paWorkers[worker].local.steals;
+        free( pool.paWorkers[worker].local.pcKeys );
+    }
+
+    printf( "{\"sessions\":%ld,\"operands_per_session\":%d,\"threads\":%d,\"steals\":%lu,\"wall_s\":%.3f,\"sessions_per_sec\":%.0f}\n",
+            sessions, operands, threadCount, steals, wallNs / 1e9, ( double ) sessions * 1e9 / wallNs );
+
+    free( pool.paWorkers );
+    return mismatches > 0;
+}
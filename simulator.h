@@ -0,0 +1,54 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "module.h"
+
+#define SIM_DEFAULT_SESSIONS 1000000L
+#define SIM_DEFAULT_OPERANDS 16 /* operands entered per virtual session */
+#define SIM_DEFAULT_SEED 42UL
+#define SIM_MAX_OPERANDS 4096
+#define SIM_MAX_SESSIONS 0xFFFFFFFFUL /* session indices are packed two to an unsigned long */
+#define SIM_MAX_THREADS 256
+#define SIM_BATCH 64 /* sessions a worker claims from its own range at once */
+#define SIM_CACHE_LINE 64
+
+/* [next, end) of a worker's sessions packed as end << 32 | next, so the owner and thieves update it with one CAS */
+#define SIM_RANGE( next, end ) ( ( ( unsigned long ) ( end ) << 32 ) | ( unsigned long ) ( next ) )
+#define SIM_RANGE_NEXT( range ) ( ( range ) & 0xFFFFFFFFUL )
+#define SIM_RANGE_END( range ) ( ( range ) >> 32 )
+
+typedef struct SimLayoutTotals
+{
+	unsigned long sessions;
+	unsigned long operands;
+	unsigned long keystrokes; /* bytes fed to userInterfaceManager, '=' included */
+	double elapsedNs; /* time spent in userInterfaceManager for this layout */
+	unsigned long mismatches; /* sessions whose total differed from the sum of their workload */
+} SimLayoutTotals;
+
+typedef struct SimWorkerLocal
+{
+	struct SimPool* pPool;
+	int index;
+	unsigned long steals; /* ranges taken from other workers */
+	SimLayoutTotals aTotals[KEYBOARD_LAYOUT_COUNT];
+	char* pcKeys; /* keystrokes of the session being run */
+} SimWorkerLocal;
+
+typedef struct SimWorker
+{
+	unsigned long range; /* sessions still to run, SIM_RANGE packed; stolen from by other workers */
+	char acRangePad[SIM_CACHE_LINE - sizeof( unsigned long )]; /* keep range apart from the counters below */
+	SimWorkerLocal local; /* only touched by the worker's own thread while it runs */
+	char acLocalPad[SIM_CACHE_LINE - sizeof( SimWorkerLocal ) % SIM_CACHE_LINE]; /* whole cache lines, so the next worker's range starts its own */
+} SimWorker;
+
+typedef struct SimPool
+{
+	SimWorker* paWorkers;
+	int workerCount;
+	int operandsPerSession;
+	unsigned long seed;
+} SimPool;
+
+#endif
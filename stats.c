@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+#define FALSE 0
+#define TRUE !FALSE
+
+#define SUB_COUNT ( 1 << STATS_SUB_BITS )
+
+static const char* const PHASE_NAMES[STATS_PHASE_COUNT] = { "input", "dispatch", "render", "write" };
+
+
+/**
+ * @brief  returns the current monotonic time in nanoseconds.
+ * @retval returns the timestamp.
+ */
+static double monotonicNs() {
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( double ) now.tv_sec * 1e9 + ( double ) now.tv_nsec;
+}
+
+
+/**
+ * @brief  maps a latency to its histogram bucket.
+ * @note   values below 2 * SUB_COUNT get a bucket each, larger values keep their top STATS_SUB_BITS + 1 bits, so every 
+ * * bucket is within about 3% of the values it holds (the same log-linear layout HDR histograms use).
+ * @retval returns the bucket index.
+ */
+static int bucketIndex( unsigned long value ) {
+    int exponent = 0;
+
+    if ( value < 2 * SUB_COUNT ) {
+        return ( int ) value;
+    }
+
+    while ( ( value >> exponent ) >= 2 * SUB_COUNT ) {
+        exponent++;
+    }
+
+    return 2 * SUB_COUNT + ( exponent - 1 ) * SUB_COUNT + ( int ) ( ( value >> exponent ) - SUB_COUNT );
+}
+
+
+/**
+ * @brief  returns the largest latency that maps to a bucket.
+ * @retval returns the value in nanoseconds.
+ */
+static unsigned long bucketValue( int index ) {
+    int exponent;
+
+    if ( index < 2 * SUB_COUNT ) {
+        return ( unsigned long ) index;
+    }
+
+    exponent = ( index - 2 * SUB_COUNT ) / SUB_COUNT + 1;
+    return ( ( ( unsigned long ) ( ( index - 2 * SUB_COUNT ) % SUB_COUNT + SUB_COUNT ) + 1 ) << exponent ) - 1;
+}
+
+
+/**
+ * @brief  returns the latency at a percentile of a phase's histogram.
+ * @retval returns the value in nanoseconds.
+ */
+static unsigned long percentile( const Stats* pStats, int phase, double fraction ) {
+    unsigned long target = ( unsigned long ) ( fraction * ( double ) pStats->aulCount[phase] + 0.5 );
+    unsigned long seen = 0;
+    int index;
+
+    if ( target < 1 ) {
+        target = 1;
+    }
+
+    for ( index = 0 ; index < STATS_BUCKET_COUNT ; index++ ) {
+        seen += pStats->aaulBuckets[phase][index];
+        if ( seen >= target ) {
+            return bucketValue( index ) < pStats->aulMaxNs[phase] ? bucketValue( index ) : pStats->aulMaxNs[phase];
+        }
+    }
+
+    return pStats->aulMaxNs[phase];
+}
+
+
+/**
+ * @brief  creates empty per-phase latency statistics.
+ * @param  trace: TRUE to also keep every event for writeStatsTrace (Type: Integer).
+ * @retval Returns Stats Struct.
+ */
+Stats* createStats( int trace ) {
+    Stats* pStats = ( Stats* ) calloc( 1, sizeof( Stats ) );
+
+    pStats->originNs = monotonicNs();
+
+    if ( trace ) {
+        pStats->eventCapacity = 65536;
+        pStats->pEvents = ( TraceEvent* ) malloc( sizeof( TraceEvent ) * ( size_t ) pStats->eventCapacity );
+    }
+
+    return pStats;
+}
+
+
+/**
+ * @brief  returns the time since the Stats were created.
+ * @param  pStats: statistics (Type: Pointer to a type defined struct called "Stats").
+ * @retval returns nanoseconds.
+ */
+unsigned long statsNow( const Stats* pStats ) {
+    return ( unsigned long ) ( monotonicNs() - pStats->originNs );
+}
+
+
+/**
+ * @brief  keeps an event for writeStatsTrace, unless STATS_MAX_TRACE_EVENTS are already kept.
+ * @retval None
+ */
+static void appendEvent( Stats* pStats, int phase, unsigned long startNs, unsigned long durationNs ) {
+    TraceEvent* pEvents;
+
+    if ( pStats->eventCount >= STATS_MAX_TRACE_EVENTS ) {
+        return;
+    }
+
+    if ( pStats->eventCount == pStats->eventCapacity ) {
+        pEvents = ( TraceEvent* ) realloc( pStats->pEvents, sizeof( TraceEvent ) * ( size_t ) pStats->eventCapacity * 2 );
+        if ( pEvents == NULL ) {
+            return;
+        }
+        pStats->pEvents = pEvents;
+        pStats->eventCapacity *= 2;
+    }
+
+    pStats->pEvents[pStats->eventCount].phase = phase;
+    pStats->pEvents[pStats->eventCount].startNs = startNs;
+    pStats->pEvents[pStats->eventCount].durationNs = durationNs;
+    pStats->eventCount++;
+}
+
+
+/**
+ * @brief  records one timed occurrence of a phase.
+ * @param  pStats: statistics (Type: Pointer to a type defined struct called "Stats").
+ * @param  phase: STATS_PHASE_INPUT, STATS_PHASE_DISPATCH, STATS_PHASE_RENDER or STATS_PHASE_WRITE (Type: Integer).
+ * @param  startNs: statsNow() when the phase started (Type: Unsigned Long).
+ * @param  endNs: statsNow() when the phase ended (Type: Unsigned Long).
+ * @retval None
+ */
+void recordPhase( Stats* pStats, int phase, unsigned long startNs, unsigned long endNs ) {
+    unsigned long duration = endNs - startNs;
+
+    pStats->aaulBuckets[phase][bucketIndex( duration )]++;
+    pStats->aulCount[phase]++;
+    pStats->adTotalNs[phase] += ( double ) duration;
+    if ( duration > pStats->aulMaxNs[phase] ) {
+        pStats->aulMaxNs[phase] = duration;
+    }
+
+    if ( pStats->pEvents != NULL ) {
+        appendEvent( pStats, phase, startNs, duration );
+    }
+}
+
+
+/**
+ * @brief  adds the phases recorded in one Stats into another.
+ * @note   Stats are not shared between threads; each thread records into its own and they are merged once the threads 
+ * * have finished. Traced events keep their time, measured from pInto's creation.
+ * @param  pInto: statistics to add to (Type: Pointer to a type defined struct called "Stats").
+ * @param  pFrom: statistics to add (Type: Pointer to a type defined struct called "Stats").
+ * @retval None
+ */
+void mergeStats( Stats* pInto, const Stats* pFrom ) {
+    const TraceEvent* pEvent;
+    double shiftNs = pFrom->originNs - pInto->originNs;
+    int phase, index;
+    long event;
+
+    for ( phase = 0 ; phase < STATS_PHASE_COUNT ; phase++ ) {
+        for ( index = 0 ; index < STATS_BUCKET_COUNT ; index++ ) {
+            pInto->aaulBuckets[phase][index] += pFrom->aaulBuckets[phase][index];
+        }
+        pInto->aulCount[phase] += pFrom->aulCount[phase];
+        pInto->adTotalNs[phase] += pFrom->adTotalNs[phase];
+        if ( pFrom->aulMaxNs[phase] > pInto->aulMaxNs[phase] ) {
+            pInto->aulMaxNs[phase] = pFrom->aulMaxNs[phase];
+        }
+    }
+
+    if ( pInto->pEvents != NULL ) {
+        for ( event = 0 ; event < pFrom->eventCount ; event++ ) {
+            pEvent = &pFrom->pEvents[event];
+            appendEvent( pInto, pEvent->phase, ( unsigned long ) ( ( double ) pEvent->startNs + shiftNs ), pEvent->durationNs );
+        }
+    }
+}
+
+
+/**
+ * @brief  prints the latency percentiles of every phase and the operand list's memory use, and what it has spilled to disk.
+ * @param  pStats: statistics (Type: Pointer to a type defined struct called "Stats").
+ * @param  pFile: file to print to, i.e. stderr (Type: Pointer to the type 'FILE').
+ * @param  pList: operand list to report on (Type: Pointer to a type defined struct called "IntList").
+ * @retval None
+ */
+void printStats( const Stats* pStats, FILE* pFile, const IntList* pList ) {
+    const IntListChunk* pChunk;
+    long chunks = 0;
+    unsigned long bytes;
+    int phase;
+
+    fprintf( pFile, "%-9s %10s %10s %10s %10s %10s %10s\n", "phase", "count", "mean_ns", "p50_ns", "p99_ns", "p999_ns", "max_ns" );
+
+    for ( phase = 0 ; phase < STATS_PHASE_COUNT ; phase++ ) {
+        if ( pStats->aulCount[phase] > 0 ) {
+            fprintf( pFile, "%-9s %10lu %10.0f %10lu %10lu %10lu %10lu\n", PHASE_NAMES[phase], pStats->aulCount[phase], 
+                     pStats->adTotalNs[phase] / ( double ) pStats->aulCount[phase], percentile( pStats, phase, 0.5 ), 
+                     percentile( pStats, phase, 0.99 ), percentile( pStats, phase, 0.999 ), pStats->aulMaxNs[phase] );
+        }
+    }
+
+    for ( pChunk = pList->head ; pChunk != NULL ; pChunk = pChunk->next ) {
+        chunks++;
+    }
+    bytes = sizeof( IntList ) + ( unsigned long ) ( chunks + ( pList->pSpare != NULL ) + ( pList->pSpillBuffer != NULL ) ) * sizeof( IntListChunk );
+
+    fprintf( pFile, "operands %ld, list chunks %ld, list bytes %lu (%.1f bytes/operand)", pList->size, chunks, bytes, 
+             pList->size > 0 ? ( double ) bytes / ( double ) pList->size : 0.0 );
+    if ( pList->spilledChunks > 0 ) {
+        fprintf( pFile, ", spilled chunks %ld (%ld operands on disk)", pList->spilledChunks, pList->spilledChunks * INT_LIST_CHUNK_CAPACITY );
+    }
+    fputc( '\n', pFile );
+}
+
+
+/**
+ * @brief  writes the traced events as a Chrome trace-event JSON file.
+ * @note   load it in chrome://tracing or Perfetto. Each phase occurrence is a complete ("X") event on its own track.
+ * @param  pStats: statistics created with tracing enabled (Type: Pointer to a type defined struct called "Stats").
+ * @param  pcPath: file to write (Type: Char array).
+ * @retval returns TRUE if the file was written.
+ */
+int writeStatsTrace( const Stats* pStats, const char* pcPath ) {
+    FILE* pFile = fopen( pcPath, "w" );
+    const TraceEvent* pEvent;
+    long index;
+    int ok;
+
+    if ( pFile == NULL ) {
+        return FALSE;
+    }
+
+    fprintf( pFile, "{\"traceEvents\":[\n" );
+    for ( index = 0 ; index < pStats->eventCount ; index++ ) {
+        pEvent = &pStats->pEvents[index];
+        fprintf( pFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", index > 0 ? ",\n" : "", 
+                 PHASE_NAMES[pEvent->phase], ( double ) pEvent->startNs / 1000.0, ( double ) pEvent->durationNs / 1000.0, pEvent->phase + 1 );
+    }
+    fprintf( pFile, "\n],\"displayTimeUnit\":\"ns\"}\n" );
+
+    ok = !ferror( pFile );
+    return ( fclose( pFile ) == 0 ) && ok;
+}
+
+
+/**
+ * @brief  frees the statistics.
+ * @param  pStats: statistics to free (Type: Pointer to a type defined struct called "Stats").
+ * @retval None
+ */
+void freeStats( Stats* pStats ) {
+    if ( pStats != NULL ) {
+        free( pStats->pEvents );
+        free( pStats );
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "intList.h"
+
+#define STATS_PHASE_INPUT 0 /* waiting for and reading keystrokes */
+#define STATS_PHASE_DISPATCH 1 /* userInterfaceManager */
+#define STATS_PHASE_RENDER 2 /* drawing the calculator */
+#define STATS_PHASE_WRITE 3 /* writeDataToFile */
+#define STATS_PHASE_COUNT 4
+
+#define STATS_SUB_BITS 5 /* 32 sub-buckets per power of two, about 3% precision */
+#define STATS_BUCKET_COUNT ( ( 1 << ( STATS_SUB_BITS + 1 ) ) + ( 64 - STATS_SUB_BITS - 1 ) * ( 1 << STATS_SUB_BITS ) )
+#define STATS_MAX_TRACE_EVENTS 4194304L /* later events are counted in the histograms but not traced */
+
+typedef struct TraceEvent
+{
+	int phase;
+	unsigned long startNs; /* since the Stats were created */
+	unsigned long durationNs;
+} TraceEvent;
+
+typedef struct Stats
+{
+	unsigned long aaulBuckets[STATS_PHASE_COUNT][STATS_BUCKET_COUNT]; /* log-linear latency histogram per phase */
+	unsigned long aulCount[STATS_PHASE_COUNT];
+	unsigned long aulMaxNs[STATS_PHASE_COUNT];
+	double adTotalNs[STATS_PHASE_COUNT];
+	double originNs; /* monotonic time the Stats were created */
+	TraceEvent* pEvents; /* NULL unless tracing */
+	long eventCount;
+	long eventCapacity;
+} Stats;
+
+
+Stats* createStats( int trace );
+unsigned long statsNow( const Stats* pStats );
+void recordPhase( Stats* pStats, int phase, unsigned long startNs, unsigned long endNs );
+void mergeStats( Stats* pInto, const Stats* pFrom );
+void printStats( const Stats* pStats, FILE* pFile, const IntList* pList );
+int writeStatsTrace( const Stats* pStats, const char* pcPath );
+void freeStats( Stats* pStats );
+
+#endif
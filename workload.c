@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include "workload.h"
+
+
+/**
+ * @brief  returns the next number of a seeded pseudo random sequence.
+ * @note   xorshift64*, so workloads are reproducible for a given seed on every platform with a 64-bit long. The state 
+ * * must not be 0.
+ * @param  pulState: generator state, updated (Type: Pointer to Unsigned Long).
+ * @retval returns the next pseudo random number.
+ */
+unsigned long nextRandom( unsigned long* pulState ) {
+    unsigned long x = *pulState;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *pulState = x;
+
+    return x * 2685821657736338717UL;
+}
+
+
+/**
+ * @brief  returns a random operand as an operator would enter it.
+ * @note   the digit count is uniform between 1 and 7, so short and long operands are equally common.
+ * @param  pulState: generator state, updated (Type: Pointer to Unsigned Long).
+ * @retval returns an operand between 1 and 9999999.
+ */
+int randomOperand( unsigned long* pulState ) {
+    static const int aiLimits[8] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+    int digits = 1 + ( int ) ( nextRandom( pulState ) % 7 );
+    int low = aiLimits[digits - 1];
+
+    return low + ( int ) ( nextRandom( pulState ) % ( unsigned long ) ( aiLimits[digits] - low ) );
+}
+
+
+/**
+ * @brief  writes the keystrokes that enter an operand and push it with '+'.
+ * @note   each glyph is reached along its shortest cursor path, see keysForGlyph.
+ * @param  pKeyboard: calculator keyboard (Type: Pointer to a type defined struct called "Keyboard").
+ * @param  piCursorKey: key the cursor is under, updated (Type: Pointer to Integer).
+ * @param  operand: positive operand of at most 7 digits (Type: Integer).
+ * @param  pcKeys: receives at most WORKLOAD_MAX_KEYS_PER_OPERAND keystrokes (Type: Char array).
+ * @retval returns the amount of keystrokes written.
+ */
+size_t keysForOperand( const Keyboard* pKeyboard, int* piCursorKey, int operand, char* pcKeys ) {
+    char acDigits[16];
+    size_t count = 0;
+    int index;
+
+    sprintf( acDigits, "%d", operand );
+
+    for ( index = 0 ; acDigits[index] != '\0' ; index++ ) {
+        count += keysForGlyph( pKeyboard, piCursorKey, acDigits[index], pcKeys + count );
+    }
+    count += keysForGlyph( pKeyboard, piCursorKey, '+', pcKeys + count );
+
+    return count;
+}
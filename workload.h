@@ -0,0 +1,14 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include "module.h"
+#include "planner.h"
+
+#define WORKLOAD_MAX_KEYS_PER_OPERAND ( 8 * PLAN_MAX_KEYS_PER_GLYPH ) /* 7 digits and '+' */
+
+unsigned long nextRandom( unsigned long* pulState );
+int randomOperand( unsigned long* pulState );
+size_t keysForOperand( const Keyboard* pKeyboard, int* piCursorKey, int operand, char* pcKeys );
+
+#endif